@@ -0,0 +1,472 @@
+// ============================= BENCHMARK =============================
+
+// Copyright (c) 2023, Jacob Bates
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This program times the hot paths of the libraries on their own, so
+// any change to them can be measured: converting between sets and
+// indices, stepping through sets, marking sets in order and at random,
+// scanning a record, each kind of expansion, and the exhaustive test
+// for a few sizes and M-values. The same inputs are used every time,
+// from a fixed seed, and each one is run a few times, keeping the
+// median, so runs on the same machine can be compared.
+
+// The results go to a file as JSON, one benchmark to a line, each with
+// its name, the number of operations in a run, the nanoseconds per
+// operation, and the sets per second. For most of them, an operation
+// is a set; for expansion, it's a set expanded, and the sets per second
+// are the sets produced. Given a file of earlier results as a baseline,
+// each result is also shown next to the one it had there, flagging any
+// that changed by more than a tenth.
+
+// The set index helpers aren't part of the library's interface, so the
+// library's source is included here whole, rather than linked.
+
+#define _DEFAULT_SOURCE
+
+#include "../lib/setRec.c"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../lib/iface.h"
+#include "../lib/expand.h"
+#include "../lib/nulTest.h"
+
+// Runs of Each Benchmark, and Change Worth Flagging
+#define RUNS 7
+#define FLAG 0.10
+
+// Record Used for Set Record Benchmarks
+#define REC_SIZE 5
+#define REC_MAXM 40
+
+// Sets Picked at Random
+#define PICKS 0x40000
+
+// Output and Baseline Files
+char *outFname;
+char *baseFname = NULL;
+
+// Something for Results to Go, so they aren't Optimized Out
+volatile size_t sink;
+
+// Shared Inputs
+SR_Base *rec = NULL;
+size_t total;
+SetVal *picks;           // random sets, REC_SIZE values each
+size_t *pickIdx;                // and their indices
+uint64_t seed = 0x9E3779B97F4A7C15;
+
+// Current Benchmark Parameters
+size_t curSize;
+unsigned long curMaxM;
+int curMode;
+
+// One Result
+typedef struct Result {
+    char name[64];
+    size_t ops;
+    double nsPerOp;
+    double setsPerSec;
+} Result;
+
+// Usage Format String
+const char *usage =
+        "Usage: %s out.json [baseline.json]\n"
+        "Results are written as JSON, and compared to the baseline "
+                "if given.\n";
+
+int main(int argc, char **argv)
+{
+    void setup(void);
+    void run(FILE *, const char *, void (*)(void), size_t (*)(size_t *),
+            bool *);
+    void clearMarks(void);
+    size_t benchSetToIndex(size_t *);
+    size_t benchIndexToSet(size_t *);
+    size_t benchIncSet(size_t *);
+    size_t benchMarkSeq(size_t *);
+    size_t benchMarkRand(size_t *);
+    size_t benchQuery(size_t *);
+    size_t benchExpand(size_t *);
+    size_t benchNulTest(size_t *);
+    int compare(const char *, const char *);
+
+    // ============ Command-Line Arguments
+    {
+        const Param params[3] = {PARAM_FNAME, PARAM_FNAME, PARAM_END};
+
+        CK_IFACE_FN(argParse(params, 1, usage, argc, argv,
+                &outFname, &baseFname));
+    }
+
+    setup();
+
+    FILE *out = fopen(outFname, "w");
+    if (out == NULL) {
+        fprintf(stderr, "Error on Opening '%s': %s\n",
+                outFname, strerror(errno));
+        return 1;
+    }
+
+    // ============ Run Benchmarks
+    fprintf(out, "{\n  \"benchmarks\": [\n");
+    bool first = true;
+    char name[64];
+
+    // Set Record
+    run(out, "setToIndex", NULL, &benchSetToIndex, &first);
+    run(out, "indexToSet", NULL, &benchIndexToSet, &first);
+    run(out, "incSetValues", NULL, &benchIncSet, &first);
+    run(out, "sr_mark/sequential", &clearMarks, &benchMarkSeq, &first);
+    run(out, "sr_mark/random", &clearMarks, &benchMarkRand, &first);
+    run(out, "sr_query/scan", NULL, &benchQuery, &first);
+
+    // Expansion, each mode
+    const struct {const char *name; int mode;} modes[3] = {
+        {"supers", EXPAND_SUPERS},
+        {"mut_add", EXPAND_MUT_ADD},
+        {"mut_mul", EXPAND_MUT_MUL}
+    };
+    for (size_t i = 0; i < 3; i++) {
+        curMode = modes[i].mode;
+        snprintf(name, sizeof(name), "expand/%s", modes[i].name);
+        run(out, name, NULL, &benchExpand, &first);
+    }
+
+    // Exhaustive Test, each size and M-value
+    const unsigned long maxms[2] = {20, 40};
+    for (curSize = 4; curSize <= 6; curSize++)
+        for (size_t i = 0; i < 2; i++) {
+            curMaxM = maxms[i];
+            snprintf(name, sizeof(name), "nulTest/n%zu/m%lu",
+                    curSize, curMaxM);
+            run(out, name, NULL, &benchNulTest, &first);
+        }
+
+    fprintf(out, "\n  ]\n}\n");
+    fclose(out);
+
+    // ============ Compare to Baseline
+    int res = 0;
+    if (baseFname != NULL) res = compare(outFname, baseFname);
+
+    sr_release(rec);
+    free(picks);
+    free(pickIdx);
+
+    return res;
+}
+
+// ============ Harness
+
+// Random Number, from a Fixed Seed
+uint64_t rnd(void)
+{
+    seed ^= seed << 13;
+    seed ^= seed >> 7;
+    seed ^= seed << 17;
+
+    return seed;
+}
+
+// Current Time
+// Returns nanoseconds from some fixed point
+double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// Random Set of Distinct Values up to an M-value, in Order
+void randomSet(SetVal *set, size_t size, unsigned long maxm)
+{
+    size_t n = 0;
+    while (n < size)
+    {
+        SetVal v = rnd() % maxm + 1, *at = set;
+        while (at < set + n && *at < v) at++;
+        if (at < set + n && *at == v) continue;
+
+        memmove(at + 1, at, (set + n - at) * sizeof(SetVal));
+        *at = v;
+        n++;
+    }
+
+    return;
+}
+
+// Set up the Shared Inputs
+void setup(void)
+{
+    rec = sr_initialize(REC_SIZE);
+    CK_PTR(rec);
+    CK_RES(sr_alloc(rec, REC_SIZE, 0, REC_MAXM, 0, NULL));
+    total = sr_getTotal(rec);
+
+    picks = calloc(PICKS * REC_SIZE, sizeof(SetVal));
+    pickIdx = calloc(PICKS, sizeof(size_t));
+    CK_PTR(picks);
+    CK_PTR(pickIdx);
+
+    size_t offset = mcn(sr_getMinM(rec) - 1, REC_SIZE);
+    for (size_t i = 0; i < PICKS; i++) {
+        SetVal *set = picks + i * REC_SIZE;
+        randomSet(set, REC_SIZE, REC_MAXM);
+        pickIdx[i] = setToIndex(set, REC_SIZE) - offset;
+    }
+
+    return;
+}
+
+// Run a Benchmark a Few Times and Write the Median
+
+// The benchmark returns the number of operations, and gives the number
+// of sets handled. Anything to get ready for a run isn't timed.
+void run(FILE *out, const char *name, void (*prep)(void),
+        size_t (*bench)(size_t *), bool *first)
+{
+    int byTime(const void *, const void *);
+
+    double times[RUNS];
+    size_t ops = 0, sets = 0;
+    for (size_t r = 0; r < RUNS; r++) {
+        if (prep != NULL) prep();
+        double start = now();
+        ops = bench(&sets);
+        times[r] = now() - start;
+    }
+    qsort(times, RUNS, sizeof(double), &byTime);
+    double t = times[RUNS / 2];
+
+    fprintf(out, "%s    {\"name\": \"%s\", \"ops\": %zu, "
+            "\"ns_per_op\": %.3f, \"sets_per_s\": %.0f}",
+            *first ? "" : ",\n", name, ops, t / ops, sets / t * 1e9);
+    *first = false;
+
+    fprintf(stderr, "%-24s %12.3f ns/op %16.0f sets/s\n",
+            name, t / ops, sets / t * 1e9);
+
+    return;
+}
+
+// Order Times, for the Median
+int byTime(const void *a, const void *b)
+{
+    double x = *(const double *) a, y = *(const double *) b;
+
+    return (x > y) - (x < y);
+}
+
+// ============ Set Record Benchmarks
+
+// Each returns the number of operations, and gives the number of sets
+// handled.
+
+size_t benchSetToIndex(size_t *sets)
+{
+    size_t acc = 0;
+    for (size_t i = 0; i < PICKS; i++)
+        acc += setToIndex(picks + i * REC_SIZE, REC_SIZE);
+    sink = acc;
+
+    *sets = PICKS;
+    return PICKS;
+}
+
+size_t benchIndexToSet(size_t *sets)
+{
+    SetVal set[REC_SIZE];
+    size_t acc = 0;
+    for (size_t i = 0; i < PICKS; i++) {
+        indexToSet(set, REC_SIZE, pickIdx[i]);
+        acc += set[0];
+    }
+    sink = acc;
+
+    *sets = PICKS;
+    return PICKS;
+}
+
+size_t benchIncSet(size_t *sets)
+{
+    SetVal set[REC_SIZE];
+    indexToSet(set, REC_SIZE, mcn(sr_getMinM(rec) - 1, REC_SIZE));
+
+    for (size_t i = 0; i < total; i++) incSetValues(set, REC_SIZE, 1);
+    sink = set[0];
+
+    *sets = total;
+    return total;
+}
+
+void clearMarks(void)
+{
+    sr_clear(rec, NULLIF);
+
+    return;
+}
+
+size_t benchMarkSeq(size_t *sets)
+{
+    SetVal set[REC_SIZE];
+    indexToSet(set, REC_SIZE, mcn(sr_getMinM(rec) - 1, REC_SIZE));
+
+    size_t acc = 0;
+    for (size_t i = 0; i < total; i++) {
+        acc += sr_mark(rec, set, REC_SIZE, NULLIF);
+        incSetValues(set, REC_SIZE, 1);
+    }
+    sink = acc;
+
+    *sets = total;
+    return total;
+}
+
+size_t benchMarkRand(size_t *sets)
+{
+    size_t acc = 0;
+    for (size_t i = 0; i < PICKS; i++)
+        acc += sr_mark(rec, picks + i * REC_SIZE, REC_SIZE, NULLIF);
+    sink = acc;
+
+    *sets = PICKS;
+    return PICKS;
+}
+
+// Scans the record left by random marking, for the unmarked sets
+size_t benchQuery(size_t *sets)
+{
+    sink = sr_query(rec, NULLIF, 0, NULL, NULL);
+
+    *sets = total;
+    return total;
+}
+
+// ============ Expansion and Test Benchmarks
+
+size_t expanded;
+
+void countExpand(const SetVal *set, size_t size)
+{
+    (void) set;
+    (void) size;
+
+    expanded++;
+
+    return;
+}
+
+// Expands a few thousand length-4 sets into a record's range
+size_t benchExpand(size_t *sets)
+{
+    const size_t n = 0x4000;
+    SetVal set[REC_SIZE - 1];
+    uint64_t saved = seed;
+
+    expanded = 0;
+    for (size_t i = 0; i < n; i++) {
+        randomSet(set, REC_SIZE - 1, REC_MAXM);
+        CK_RES(expand(set, REC_SIZE - 1, REC_SIZE, REC_MAXM, curMode,
+                &countExpand));
+    }
+    seed = saved;
+
+    *sets = expanded;
+    return n;
+}
+
+// Tests random sets of the current size and M-value
+size_t benchNulTest(size_t *sets)
+{
+    const size_t n = curSize < 5 ? 0x40000 : curSize < 6 ? 0x10000
+            : 0x2000;
+    SetVal set[6];
+    uint64_t saved = seed;
+
+    size_t acc = 0;
+    for (size_t i = 0; i < n; i++) {
+        randomSet(set, curSize, curMaxM);
+        int res = nulTest(set, curSize, 0, 0);
+        CK_RES(res);
+        acc += res;
+    }
+    sink = acc;
+    seed = saved;
+
+    *sets = n;
+    return n;
+}
+
+// ============ Baseline Comparison
+
+// Read Results from a File
+// Returns the number read, -1 on error
+
+// Only reads files in the format written here, one result to a line.
+ssize_t readResults(const char *fname, Result *res, size_t max)
+{
+    FILE *f = fopen(fname, "r");
+    if (f == NULL) {
+        fprintf(stderr, "Error on Opening '%s': %s\n",
+                fname, strerror(errno));
+        return -1;
+    }
+
+    char line[256];
+    size_t n = 0;
+    while (n < max && fgets(line, sizeof(line), f) != NULL)
+    {
+        Result *r = res + n;
+        if (sscanf(line, " {\"name\": \"%63[^\"]\", \"ops\": %zu, "
+                "\"ns_per_op\": %lf, \"sets_per_s\": %lf}",
+                r->name, &r->ops, &r->nsPerOp, &r->setsPerSec) == 4)
+            n++;
+    }
+
+    fclose(f);
+    return n;
+}
+
+// Compare Results to a Baseline
+// Returns 0 if nothing's slower by more than the flagged change, 1
+// otherwise, 2 on error
+int compare(const char *curFname, const char *baseFname)
+{
+    Result cur[64], base[64];
+    ssize_t curc = readResults(curFname, cur, 64);
+    ssize_t basec = readResults(baseFname, base, 64);
+    if (curc < 0 || basec < 0) return 2;
+
+    printf("%-24s %12s %12s %8s\n", "Benchmark", "Base ns/op",
+            "Now ns/op", "Change");
+
+    int slower = 0;
+    for (ssize_t i = 0; i < curc; i++)
+    {
+        Result *b = NULL;
+        for (ssize_t j = 0; j < basec; j++)
+            if (strcmp(cur[i].name, base[j].name) == 0) b = base + j;
+
+        if (b == NULL) {
+            printf("%-24s %12s %12.3f %8s\n", cur[i].name, "--",
+                    cur[i].nsPerOp, "new");
+            continue;
+        }
+
+        double change = cur[i].nsPerOp / b->nsPerOp - 1;
+        const char *flag = change > FLAG ? " slower"
+                : change < -FLAG ? " faster" : "";
+        if (change > FLAG) slower = 1;
+
+        printf("%-24s %12.3f %12.3f %+7.1f%%%s\n", cur[i].name,
+                b->nsPerOp, cur[i].nsPerOp, change * 100, flag);
+    }
+
+    return slower;
+}
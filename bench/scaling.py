@@ -0,0 +1,211 @@
+#!/usr/bin/python
+
+import argparse
+import csv
+import json
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+
+# Runs Generation and Weed on the same records at a range of thread
+# counts, to see how well they scale. For each run, it notes the wall
+# time, the sets gone through per second, and the peak memory, and
+# works out the speedup over one thread and the parallel efficiency,
+# the speedup divided by the thread count. Runs with efficiency below
+# the threshold are flagged.
+#
+# Records are made the same way as in `autoinnull', for each set size
+# and M-value asked for: Generation is run from the record one size
+# down, and Weed on the record of that size, fresh each time, as it
+# marks sets as tested and would skip them the next time. Existing
+# records can be given too, and are used in the same way.
+#
+# Usage: ./bench/scaling.py [-n 5 6] [-m 40] [-t 8] [-o scaling]
+
+RECORD_DATA = 0x1000
+RECORD_HEADER = 0x800
+
+# seconds between reading a running program's memory
+POLL = 0.005
+
+def parseThreads(arg):
+    if "," in arg:
+        return [int(t) for t in arg.split(",")]
+    return list(range(1, int(arg) + 1))
+
+# set size of an existing record, from its header
+def recordSize(fname):
+    with open(fname, "rb") as f:
+        f.seek(RECORD_HEADER)
+        line = f.readline().decode()
+    if not line.startswith("Full Set -- Size: "):
+        sys.exit(f"Error: '{fname}' isn't a record")
+    return int(line.split(":")[1])
+
+def recordTotal(fname):
+    return os.path.getsize(fname) - RECORD_DATA
+
+def call(args):
+    subprocess.run(args, check=True, stdout=subprocess.DEVNULL,
+            stderr=subprocess.DEVNULL)
+
+# makes records of each size up to the one given, like `autoinnull'
+def makeRecords(bindir, workdir, size, maxm, threads):
+    recs = {}
+    fname = os.path.join(workdir, f"rec-3-{maxm}.dat")
+    call([f"{bindir}/create", "3", "0", str(maxm), "0", "", fname])
+    call([f"{bindir}/weed", "3", fname, "0", "0", str(threads)])
+    recs[3] = fname
+
+    for n in range(3, size):
+        dest = os.path.join(workdir, f"rec-{n + 1}-{maxm}.dat")
+        call([f"{bindir}/gen", "-c", str(n), recs[n], dest,
+                str(threads)])
+        recs[n + 1] = dest
+
+    return recs
+
+# peak memory of a running process in kilobytes, or none once it's gone
+def peakMemory(pid):
+    try:
+        with open(f"/proc/{pid}/status") as f:
+            for line in f:
+                if line.startswith("VmHWM:"):
+                    return int(line.split()[1])
+    except OSError:
+        pass
+    return None
+
+# runs a program, returning the wall time and peak memory in kilobytes
+#
+# The peak that comes back from waiting on it counts the memory of this
+# script from before it started the program, so the program's own peak
+# is read while it runs, up until it exits.
+def timed(args):
+    start = time.perf_counter()
+    proc = subprocess.Popen(args, stdout=subprocess.DEVNULL,
+            stderr=subprocess.DEVNULL)
+    peak = 0
+    while True:
+        peak = max(peak, peakMemory(proc.pid) or 0)
+        pid, status, usage = os.wait4(proc.pid, os.WNOHANG)
+        if pid != 0:
+            break
+        time.sleep(POLL)
+    wall = time.perf_counter() - start
+    proc.returncode = status
+    if status != 0:
+        sys.exit(f"Error: {' '.join(args)} failed")
+    return wall, peak or usage.ru_maxrss
+
+def runGen(bindir, workdir, src, size, threads):
+    dest = os.path.join(workdir, "dest.dat")
+    wall, rss = timed([f"{bindir}/gen", "-c", str(size), src, dest,
+            str(threads)])
+    os.remove(dest)
+    return wall, rss, recordTotal(src)
+
+def runWeed(bindir, workdir, rec, size, threads):
+    fresh = os.path.join(workdir, "weed.dat")
+    shutil.copyfile(rec, fresh)
+    wall, rss = timed([f"{bindir}/weed", str(size), fresh, "0", "0",
+            str(threads)])
+    os.remove(fresh)
+    return wall, rss, recordTotal(rec)
+
+# runs one program on one record at every thread count
+def scale(label, run, threads, repeat):
+    rows = []
+    base = None
+    for t in threads:
+        results = [run(t) for _ in range(repeat)]
+        wall, rss, total = min(results)
+        if base is None:
+            base = wall * threads[0]
+        speedup = base / wall
+        rows.append(dict(label, threads=t, wall_s=round(wall, 4),
+                sets_per_s=round(total / wall), peak_rss_kb=rss,
+                speedup=round(speedup, 3),
+                efficiency=round(speedup / t, 3)))
+        print(f"{label['program']:4} n={label['size']} "
+                f"{label['record']:>24} t={t:<3} {wall:9.3f}s "
+                f"{total / wall:14.0f} sets/s {rss:9d} KB "
+                f"eff {speedup / t:5.2f}", file=sys.stderr)
+    return rows
+
+def main():
+    parser = argparse.ArgumentParser(
+            description="Measure how gen and weed scale with threads")
+    parser.add_argument("-n", "--sizes", type=int, nargs="+",
+            default=[5], help="set sizes to make records for")
+    parser.add_argument("-m", "--maxm", type=int, default=40,
+            help="M-value of records made")
+    parser.add_argument("-r", "--record", action="append", default=[],
+            help="existing record to use as well")
+    parser.add_argument("-t", "--threads", type=parseThreads,
+            default=parseThreads(str(os.cpu_count())),
+            help="thread counts, as a list like 1,2,4 or a maximum")
+    parser.add_argument("-p", "--programs", nargs="+",
+            choices=["gen", "weed"], default=["gen", "weed"])
+    parser.add_argument("-k", "--repeat", type=int, default=1,
+            help="runs at each thread count, keeping the fastest")
+    parser.add_argument("-e", "--threshold", type=float, default=0.7,
+            help="flag runs with parallel efficiency below this")
+    parser.add_argument("-b", "--bin", default="./bin",
+            help="where the programs are")
+    parser.add_argument("-w", "--workdir", default="/dev/shm",
+            help="where to keep records while running")
+    parser.add_argument("-o", "--output", default="scaling",
+            help="report name, written as .json and .csv")
+    args = parser.parse_args()
+
+    if min(args.sizes) < 4:
+        parser.error("sizes must be at least 4")
+
+    work = tempfile.mkdtemp(prefix="scaling.", dir=args.workdir)
+    rows = []
+    try:
+        # records of each size, the ones asked for and one size down
+        jobs = []
+        for size in args.sizes:
+            recs = makeRecords(args.bin, work, size, args.maxm,
+                    max(args.threads))
+            jobs.append((size, recs[size - 1], recs[size],
+                    f"made M={args.maxm}"))
+        for fname in args.record:
+            size = recordSize(fname)
+            jobs.append((size + 1, fname, None, fname))
+            jobs.append((size, None, fname, fname))
+
+        for size, src, rec, name in jobs:
+            if "gen" in args.programs and src is not None:
+                label = dict(program="gen", size=size, record=name)
+                rows += scale(label, lambda t: runGen(args.bin, work,
+                        src, size - 1, t), args.threads, args.repeat)
+            if "weed" in args.programs and rec is not None:
+                label = dict(program="weed", size=size, record=name)
+                rows += scale(label, lambda t: runWeed(args.bin, work,
+                        rec, size, t), args.threads, args.repeat)
+    finally:
+        shutil.rmtree(work)
+
+    with open(args.output + ".json", "w") as f:
+        json.dump(rows, f, indent=2)
+    with open(args.output + ".csv", "w", newline="") as f:
+        writer = csv.DictWriter(f, fieldnames=list(rows[0]))
+        writer.writeheader()
+        writer.writerows(rows)
+
+    low = [r for r in rows if r["efficiency"] < args.threshold]
+    for r in low:
+        print(f"Low efficiency: {r['program']} n={r['size']} "
+                f"{r['record']} at {r['threads']} threads, "
+                f"{r['efficiency']:.2f}", file=sys.stderr)
+
+    return 1 if low else 0
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,106 @@
+#!/usr/bin/env python3
+
+import itertools
+import sys
+
+# Writes out the nullifiability test for length-4 and length-5 sets as
+# straight-line code, in the same way as the recursive test goes about
+# it, but with every pair and every remaining value spelled out, so
+# there's no allocation or recursion. Each reduction of a length-4 set
+# leaves three values, which are checked in place, with the sums and
+# products of the two untouched values worked out once per pair. Each
+# reduction of a length-5 set is passed on to the length-4 test.
+#
+# Usage: ./genkernels.py > lib/nulKernels.h
+
+header = """\
+// =================== GENERATED NULLIFIABILITY TESTS ==================
+
+// Generated by `genkernels.py', don't edit by hand. This is included in
+// `nulTest.c', which has the helper functions these use.
+"""
+
+# maximum of some values from the set, as a C expression
+def maxOf(idx):
+    expr = f"s[{idx[0]}]"
+    for i in idx[1:]:
+        expr = f"maxValue({expr}, s[{i}])"
+    return expr
+
+# the range checks on the reduction of a pair, as in the recursive test
+def pairBlock(n, a, b, body):
+    rest = [i for i in range(n) if i != a and i != b]
+    lines = [
+        f"    // Reduce s[{a}] and s[{b}]",
+        f"    m = {maxOf(rest)};",
+        f"    if (maxm == 0 || m <= maxm) {{",
+        f"        pairValues(s[{a}], s[{b}], r);",
+    ]
+    lines += ["        " + line for line in body(rest)]
+    lines += ["    }", ""]
+    return lines
+
+# the three values left, checked in place
+def tripletBody(rest):
+    x, y = rest
+    return [
+        f"x = s[{x}], y = s[{y}], sum = x + y, prod = x * y;",
+        "for (size_t i = 0; i < 4; i++)",
+        "    if (r[i] != 0 && inRange(r[i], m, minm, maxm))",
+        "        if (r[i] == x || r[i] == y || r[i] == sum",
+        "                || r[i] == prod || r[i] + x == y",
+        "                || r[i] + y == x || r[i] * x == y",
+        "                || r[i] * y == x) return 0;",
+    ]
+
+# the four values left, passed on
+def quadBody(rest):
+    vals = ", ".join(f"s[{i}]" for i in rest)
+    return [
+        "for (size_t i = 0; i < 4; i++)",
+        "    if (r[i] != 0 && inRange(r[i], m, minm, maxm)) {",
+        f"        const unsigned long t[4] = {{r[i], {vals}}};",
+        "        if (nulTest4(t, 0, 0) == 0) return 0;",
+        "    }",
+    ]
+
+def kernel(n, locals, body):
+    pairs = list(itertools.combinations(range(n), 2))
+    eq = [f"s[{a}] == s[{b}]" for a, b in pairs]
+
+    lines = [
+        f"// Test if a Length-{n} Set is Nullifiable or Not",
+        "// Returns 0 if nullifiable, 1 if innullifiable",
+        f"static int nulTest{n}(const unsigned long s[{n}],",
+        "        unsigned long minm, unsigned long maxm)",
+        "{",
+        f"    {locals};",
+        "",
+        "    // Simple equality",
+    ]
+
+    # break the equality checks over lines, three to a line
+    cond = [" || ".join(eq[i:i + 3]) for i in range(0, len(eq), 3)]
+    lines.append(f"    if ({cond[0]}")
+    for part in cond[1:]:
+        lines.append(f"            || {part}")
+    lines[-1] += ") return 0;"
+    lines.append("")
+
+    for a, b in pairs:
+        lines += pairBlock(n, a, b, body)
+
+    lines += ["    return 1;", "}", ""]
+    return lines
+
+if __name__ == '__main__':
+    if len(sys.argv) != 1:
+        print("Usage: ./genkernels.py > lib/nulKernels.h")
+        sys.exit(1)
+
+    lines = [header]
+    lines += kernel(4, "unsigned long m, r[4], x, y, sum, prod",
+            tripletBody)
+    lines += kernel(5, "unsigned long m, r[4]", quadBody)
+
+    sys.stdout.write("\n".join(lines))
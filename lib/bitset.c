@@ -0,0 +1,219 @@
+// ============================== BITSETS ==============================
+
+// Copyright (c) 2023, Jacob Bates
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This library has some kernels for working with fixed-width bitsets,
+// arrays of 64-bit words where bit N says whether the value N is in the
+// set. It's for holding sets of values in a bounded range, where taking
+// a union or checking for an intersection is just a pass over the words,
+// and adding some amount to every value is a shift. Lengths are given
+// in words, and bits shifted beyond the end are dropped.
+
+// When compiled with AVX2 available, the passes go four words at a
+// time; otherwise they're plain loops over words.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+#include "bitset.h"
+
+// Clear a Bitset
+void bs_clear(uint64_t *dst, size_t words)
+{
+    for (size_t i = 0; i < words; i++) dst[i] = 0;
+
+    return;
+}
+
+// Union of Bitsets
+
+// ORs the source into the destination.
+void bs_or(uint64_t *dst, const uint64_t *src, size_t words)
+{
+    size_t i = 0;
+
+#ifdef __AVX2__
+    for (; i + 4 <= words; i += 4)
+    {
+        __m256i d = _mm256_loadu_si256((const __m256i *) (dst + i));
+        __m256i s = _mm256_loadu_si256((const __m256i *) (src + i));
+        _mm256_storeu_si256((__m256i *) (dst + i),
+                _mm256_or_si256(d, s));
+    }
+#endif
+
+    for (; i < words; i++) dst[i] |= src[i];
+
+    return;
+}
+
+// Union with a Shifted Bitset
+
+// ORs the source into the destination, shifted up by some number of
+// bits, which adds that number to every value.
+void bs_orShl(uint64_t *dst, const uint64_t *src, size_t shift,
+        size_t words)
+{
+    size_t q = shift / 64;
+    unsigned r = shift % 64;
+    if (q >= words) return;
+
+    // Whole-word shift is just a copy across
+    if (r == 0) {
+        bs_or(dst + q, src, words - q);
+        return;
+    }
+
+    // First word only has one source word going into it
+    dst[q] |= src[0] << r;
+    size_t i = q + 1;
+
+#ifdef __AVX2__
+    __m128i lo = _mm_cvtsi32_si128(r);
+    __m128i hi = _mm_cvtsi32_si128(64 - r);
+    for (; i + 4 <= words; i += 4)
+    {
+        __m256i a = _mm256_loadu_si256(
+                (const __m256i *) (src + i - q));
+        __m256i b = _mm256_loadu_si256(
+                (const __m256i *) (src + i - q - 1));
+        __m256i v = _mm256_or_si256(_mm256_sll_epi64(a, lo),
+                _mm256_srl_epi64(b, hi));
+        __m256i d = _mm256_loadu_si256((const __m256i *) (dst + i));
+        _mm256_storeu_si256((__m256i *) (dst + i),
+                _mm256_or_si256(d, v));
+    }
+#endif
+
+    for (; i < words; i++)
+        dst[i] |= src[i - q] << r | src[i - q - 1] >> (64 - r);
+
+    return;
+}
+
+// ORs the source into the destination, shifted down by some number of
+// bits, which subtracts that number from every value, dropping any that
+// go below zero.
+void bs_orShr(uint64_t *dst, const uint64_t *src, size_t shift,
+        size_t words)
+{
+    size_t q = shift / 64;
+    unsigned r = shift % 64;
+    if (q >= words) return;
+
+    // Whole-word shift is just a copy across
+    if (r == 0) {
+        bs_or(dst, src + q, words - q);
+        return;
+    }
+
+    // Every word but the last has two source words going into it
+    size_t i = 0;
+    size_t last = words - q - 1;
+
+#ifdef __AVX2__
+    __m128i lo = _mm_cvtsi32_si128(r);
+    __m128i hi = _mm_cvtsi32_si128(64 - r);
+    for (; i + 4 <= last; i += 4)
+    {
+        __m256i a = _mm256_loadu_si256(
+                (const __m256i *) (src + i + q));
+        __m256i b = _mm256_loadu_si256(
+                (const __m256i *) (src + i + q + 1));
+        __m256i v = _mm256_or_si256(_mm256_srl_epi64(a, lo),
+                _mm256_sll_epi64(b, hi));
+        __m256i d = _mm256_loadu_si256((const __m256i *) (dst + i));
+        _mm256_storeu_si256((__m256i *) (dst + i),
+                _mm256_or_si256(d, v));
+    }
+#endif
+
+    for (; i < last; i++)
+        dst[i] |= src[i + q] >> r | src[i + q + 1] << (64 - r);
+    dst[last] |= src[last + q] >> r;
+
+    return;
+}
+
+// Check for Intersection of Bitsets
+// Returns whether there is a value in both
+bool bs_intersects(const uint64_t *a, const uint64_t *b, size_t words)
+{
+    size_t i = 0;
+
+#ifdef __AVX2__
+    for (; i + 4 <= words; i += 4)
+    {
+        __m256i x = _mm256_loadu_si256((const __m256i *) (a + i));
+        __m256i y = _mm256_loadu_si256((const __m256i *) (b + i));
+        if (!_mm256_testz_si256(x, y)) return true;
+    }
+#endif
+
+    for (; i < words; i++) if (a[i] & b[i]) return true;
+
+    return false;
+}
+
+// Returns whether there is a value in the second bitset which is some
+// value from the first plus the given shift
+bool bs_intersectsShl(const uint64_t *a, const uint64_t *b,
+        size_t shift, size_t words)
+{
+    size_t q = shift / 64;
+    unsigned r = shift % 64;
+    if (q >= words) return false;
+
+    // Whole-word shift is a plain intersection
+    if (r == 0) return bs_intersects(a, b + q, words - q);
+
+    // First word only has one word from the first bitset
+    if ((a[0] << r) & b[q]) return true;
+    size_t i = q + 1;
+
+#ifdef __AVX2__
+    __m128i lo = _mm_cvtsi32_si128(r);
+    __m128i hi = _mm_cvtsi32_si128(64 - r);
+    for (; i + 4 <= words; i += 4)
+    {
+        __m256i x = _mm256_loadu_si256((const __m256i *) (a + i - q));
+        __m256i y = _mm256_loadu_si256(
+                (const __m256i *) (a + i - q - 1));
+        __m256i v = _mm256_or_si256(_mm256_sll_epi64(x, lo),
+                _mm256_srl_epi64(y, hi));
+        __m256i d = _mm256_loadu_si256((const __m256i *) (b + i));
+        if (!_mm256_testz_si256(v, d)) return true;
+    }
+#endif
+
+    for (; i < words; i++)
+        if ((a[i - q] << r | a[i - q - 1] >> (64 - r)) & b[i])
+            return true;
+
+    return false;
+}
+
+// Find Next Set Bit
+// Returns the index of the bit, or the total number of bits if none
+
+// Finds the first set bit at or after the given index.
+size_t bs_next(const uint64_t *bs, size_t words, size_t from)
+{
+    size_t i = from / 64;
+    if (i >= words) return words * 64;
+
+    // Mask off the bits before the starting point in the first word
+    uint64_t w = bs[i] & (~(uint64_t) 0 << (from % 64));
+    while (w == 0) {
+        if (++i == words) return words * 64;
+        w = bs[i];
+    }
+
+    return i * 64 + __builtin_ctzll(w);
+}
@@ -0,0 +1,45 @@
+// ============================== BITSETS ==============================
+
+// See more info about this library in the source file `bitset.c'.
+
+#ifndef BITSET_H
+#define BITSET_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+// Number of Words for a Number of Bits
+#define BS_WORDS(bits) (((bits) + 63) / 64)
+
+// Test a Bit
+static inline bool bs_test(const uint64_t *bs, size_t bit)
+{
+    return bs[bit / 64] >> (bit % 64) & 1;
+}
+
+// Set a Bit
+static inline void bs_set(uint64_t *bs, size_t bit)
+{
+    bs[bit / 64] |= (uint64_t) 1 << (bit % 64);
+}
+
+// Clear a Bitset
+void bs_clear(uint64_t *, size_t);
+
+// Union of Bitsets
+void bs_or(uint64_t *, const uint64_t *, size_t);
+
+// Union with a Shifted Bitset
+void bs_orShl(uint64_t *, const uint64_t *, size_t, size_t);
+void bs_orShr(uint64_t *, const uint64_t *, size_t, size_t);
+
+// Check for Intersection of Bitsets
+bool bs_intersects(const uint64_t *, const uint64_t *, size_t);
+bool bs_intersectsShl(const uint64_t *, const uint64_t *, size_t,
+        size_t);
+
+// Find Next Set Bit
+size_t bs_next(const uint64_t *, size_t, size_t);
+
+#endif
@@ -28,6 +28,13 @@
 // to get the set (3, 4, 5, 8), which we know must also be nullifiable
 // since that 4 and 8 can divide to get 2--and the original set--back.
 
+// Going the other way, a set can be reduced a single step, by taking
+// out any one of its values, which undoes a superset, or by merging any
+// pair of its values into one, which undoes a mutation. Every set that
+// expands into a given set is one of its reductions, so rather than
+// expanding every nullifiable set, a set can be checked by going
+// through its reductions until one is found to be nullifiable.
+
 #include <stdlib.h>
 #include <stdbool.h>
 
@@ -35,23 +42,64 @@
 
 #include "expand.h"
 
+// Sizes with their Own Kernels, Function Attributes for Kernels
+#define KERN_MAX 12
+#define KERNEL static inline __attribute__((always_inline))
+
+// Output Function
+typedef void OutFun(const SetVal *, size_t);
+
 // Helper Function Declarations
-static int supers(const unsigned long *, size_t,
-        unsigned long, unsigned long,
-        void (*)(const unsigned long *, size_t));
-static int mutate(const unsigned long *, size_t,
-        unsigned long, unsigned long, bool, bool,
-        void (*)(const unsigned long *, size_t));
+KERNEL int expandSized(const SetVal *, size_t,
+        unsigned long, unsigned long, int, OutFun *, SetVal *);
+KERNEL void supers(const SetVal *, size_t,
+        unsigned long, unsigned long, OutFun *, SetVal *);
+KERNEL void mutate(const SetVal *, size_t,
+        unsigned long, unsigned long, bool, bool, OutFun *,
+        SetVal *);
+
+KERNEL void insertEqPair(SetVal *, size_t, size_t,
+        const SetVal *, unsigned long, unsigned long, OutFun *);
+
+// Acceptance Function
+typedef bool AcceptFun(const SetVal *, size_t);
+
+KERNEL int reduceInto(const SetVal *, size_t, int, AcceptFun *,
+        SetVal *);
+KERNEL bool mergePair(const SetVal *, size_t, size_t, size_t,
+        unsigned long, AcceptFun *, SetVal *);
+
+// ============ Kernels
+
+// Expansion is made again for each input size up to a point, with the
+// size fixed, so the loops over the set's values can be unrolled and
+// the expanded set kept on the stack. Any larger size uses the general
+// one, with the expanded set allocated.
+
+#define KERNELS(N) \
+    static int expand##N(const SetVal *set, \
+            unsigned long minM, unsigned long maxM, int mode, \
+            OutFun *out) \
+    { \
+        SetVal eSet[N + 1]; \
+        return expandSized(set, N, minM, maxM, mode, out, eSet); \
+    }
+
+KERNELS(1) KERNELS(2) KERNELS(3) KERNELS(4) KERNELS(5) KERNELS(6)
+KERNELS(7) KERNELS(8) KERNELS(9) KERNELS(10) KERNELS(11) KERNELS(12)
 
-static void insertEqPair(unsigned long *, size_t, size_t,
-        const unsigned long *, unsigned long, unsigned long,
-        void (*)(const unsigned long *, size_t));
+// Kernels by Input Size
+static int (*const kernels[KERN_MAX + 1])(const SetVal *,
+        unsigned long, unsigned long, int, OutFun *) = {
+    NULL, &expand1, &expand2, &expand3, &expand4, &expand5, &expand6,
+    &expand7, &expand8, &expand9, &expand10, &expand11, &expand12
+};
 
 // Produce All Set Expansions
 // Returns 0 on success, -1 on error (check errno)
-int expand(const unsigned long *set, size_t size,
+int expand(const SetVal *set, size_t size,
         unsigned long minM, unsigned long maxM, int mode,
-        void (*out)(const unsigned long *, size_t))
+        void (*out)(const SetVal *, size_t))
 {
 #ifndef NO_VALIDATE
     // Validate Input Set: values are positive and ascending
@@ -59,43 +107,103 @@ int expand(const unsigned long *set, size_t size,
     if (set[0] < 1) return -1;
     for (size_t i = 1; i < size; i++)
         if (set[i] <= set[i - 1]) return -1;
+
+    // And the expansions will fit in a set
+    if (maxM > SET_VAL_MAX) return -1;
     errno = 0;
 #endif
 
     // If no output, skip all this work
     if (out == NULL) return 0;
 
+    // Sizes with their own kernel
+    if (size >= 1 && size <= KERN_MAX)
+        return kernels[size](set, minM, maxM, mode, out);
+
+    // Otherwise, space for the expanded set
+    SetVal *eSet = calloc(size + 1, sizeof(SetVal));
+    if (eSet == NULL) return -1;
+
+    int res = expandSized(set, size, minM, maxM, mode, out, eSet);
+    free(eSet);
+
+    return res;
+}
+
+// Produce Set Reductions until One is Accepted
+// Returns 1 if one was accepted, 0 if none were, -1 on error (check
+// errno)
+
+// Each reduction of the input set, one value smaller, is passed to the
+// acceptance function in turn, until it returns true. Which reductions
+// are gone through is given by the same modes as expansion: taking out
+// values undoes supersets, and merging pairs by sum or difference, and
+// by product or quotient, undoes additive and multiplicative mutations.
+int reduce(const SetVal *set, size_t size, int mode,
+        bool (*accept)(const SetVal *, size_t))
+{
+#ifndef NO_VALIDATE
+    // Validate Input Set: values are positive and ascending
+    errno = EINVAL;
+    if (set[0] < 1) return -1;
+    for (size_t i = 1; i < size; i++)
+        if (set[i] <= set[i - 1]) return -1;
+    errno = 0;
+#endif
+
+    // Nothing to reduce to, or no one to accept it
+    if (size < 2 || accept == NULL) return 0;
+
+    // Space for the reduced set, on the stack if it's small enough
+    SetVal small[KERN_MAX];
+    SetVal *rSet = small;
+    if (size - 1 > KERN_MAX) {
+        rSet = calloc(size - 1, sizeof(SetVal));
+        if (rSet == NULL) return -1;
+    }
+
+    int res = reduceInto(set, size, mode, accept, rSet);
+    if (rSet != small) free(rSet);
+
+    return res;
+}
+
+// ============ Helper Functions
+
+// Produce All Set Expansions, of a Known Size
+// Returns 0 on success
+
+// Expanded sets are put together in the given space, which holds one
+// more value than the input.
+int expandSized(const SetVal *set, size_t size,
+        unsigned long minM, unsigned long maxM, int mode, OutFun *out,
+        SetVal *eSet)
+{
     // We can't remove values, so if there are two values specifically
     // above the M-range, mutation won't work
     if (size >= 2) if (set[size - 2] > maxM) return 0;
 
     // Mutations
     mutate(set, size, minM, maxM,
-            mode & EXPAND_MUT_ADD, mode & EXPAND_MUT_MUL, out);
+            mode & EXPAND_MUT_ADD, mode & EXPAND_MUT_MUL, out, eSet);
 
     // And if there's even one such value, supersets won't work
     if (size >= 1) if (set[size - 1] > maxM) return 0;
 
     // Supersets
-    if (mode & EXPAND_SUPERS) supers(set, size, minM, maxM, out);
+    if (mode & EXPAND_SUPERS) supers(set, size, minM, maxM, out, eSet);
 
     return 0;
 }
 
-// ============ Helper Functions
-
 // Enumerate Supersets
-// Returns 0 on success, -1 on error (check errno)
 
 // Accepts a set that's not above the M-range, and outputs all supersets
-// within the M-range.
-int supers(const unsigned long *set, size_t size,
-        unsigned long minM, unsigned long maxM,
-        void (*out)(const unsigned long *, size_t))
+// within the M-range, putting them together in the given space.
+void supers(const SetVal *set, size_t size,
+        unsigned long minM, unsigned long maxM, OutFun *out,
+        SetVal *super)
 {
-    // Set Representation
-    unsigned long *super = calloc(size + 1, sizeof(unsigned long));
-    if (super == NULL) return -1;
 
     // Check relation to M-range
     bool belowMRange = set[size - 1] < minM;
@@ -122,28 +230,21 @@ int supers(const unsigned long *set, size_t size,
         if (!skip) out(super, size + 1);
     }
 
-    free(super);
-
-    return 0;
+    return;
 }
 
 // Enumerate Set Mutations
-// Returns 0 on success, -1 on error (check errno)
 
 // Accepts a set that's not above the M-range, or which has only one
 // value 'poking out', and outputs all mutations within the M-range. It
 // can be specified which mutation modes to use (additive,
-// multiplicative).
-int mutate(const unsigned long *set, size_t size,
+// multiplicative). Expanded sets are put together in the given space.
+void mutate(const SetVal *set, size_t size,
         unsigned long minM, unsigned long maxM, bool add, bool mul,
-        void (*out)(const unsigned long *, size_t))
+        OutFun *out, SetVal *eSet)
 {
     // No mutations of null set
-    if (size < 1) return 0;
-
-    // Set Representation for Expanded Set
-    unsigned long *eSet = calloc(size + 1, sizeof(unsigned long));
-    if (eSet == NULL) return -1;
+    if (size < 1) return;
 
     // Check relation to M-range
     unsigned long mval = set[size - 1];
@@ -177,9 +278,8 @@ int mutate(const unsigned long *set, size_t size,
         {
             // Sum Equivalent Pairs: iterate over larger addends
             if (add) for (unsigned long major = mutVal - 1;
-                    major > mutVal / 2; major--)
+                    major > mutVal / 2 && major >= minMajor; major--)
             {
-                if (major < minMajor) continue;
                 unsigned long minor = mutVal - major;
                 insertEqPair(eSet, size + 1, mutPt, set,
                         minor, major, out);
@@ -191,7 +291,7 @@ int mutate(const unsigned long *set, size_t size,
             {
                 if (mutVal % minor != 0) continue;
                 unsigned long major = mutVal / minor;
-                if (major < minMajor) continue;
+                if (major < minMajor) break;
                 insertEqPair(eSet, size + 1, mutPt, set,
                         minor, major, out);
             }
@@ -202,37 +302,36 @@ int mutate(const unsigned long *set, size_t size,
         // nothing poking out above the range
         if (inMRange || belowMRange)
         {
-            // Difference Equivalent Pairs: iterate over minuends
-            if (add) for (unsigned long minuend = mutVal + 1;
-                    minuend <= maxM; minuend++)
+            // Difference Equivalent Pairs: iterate over minuends, from
+            // the lowest that's allowed
+            if (add) for (unsigned long minuend = mutVal + 1 > minMajor
+                    ? mutVal + 1 : minMajor; minuend <= maxM; minuend++)
             {
-                if (minuend < minMajor) continue;
                 unsigned long subtrahend = minuend - mutVal;
                 insertEqPair(eSet, size + 1, mutPt, set,
                         subtrahend, minuend, out);
             }
 
-            // Quotient Equivalent Pairs: iterate over divisors
-            if (mul) for (unsigned long divisor = 1;
+            // Quotient Equivalent Pairs: iterate over divisors, from
+            // the lowest that's allowed
+            if (mul) for (unsigned long divisor = minMajor > mutVal
+                    ? (minMajor - 1) / mutVal + 1 : 1;
                     divisor <= maxM / mutVal; divisor++)
             {
                 unsigned long dividend = mutVal * divisor;
-                if (dividend < minMajor) continue;
                 insertEqPair(eSet, size + 1, mutPt, set,
                         divisor, dividend, out);
             }
         }
     }
 
-    free(eSet);
-
-    return 0;
+    return;
 }
 
 // Insert Equivalent Pair into Set, Output
-void insertEqPair(unsigned long *eSet, size_t eSize, size_t mutPt,
-        const unsigned long *set, unsigned long minor,
-        unsigned long major, void (*out)(const unsigned long *, size_t))
+void insertEqPair(SetVal *eSet, size_t eSize, size_t mutPt,
+        const SetVal *set, unsigned long minor,
+        unsigned long major, OutFun *out)
 {
     // Can't create a double value
     if (minor == major) return;
@@ -267,3 +366,86 @@ void insertEqPair(unsigned long *eSet, size_t eSize, size_t mutPt,
 
     return;
 }
+
+// Go Through Set Reductions
+// Returns 1 if one was accepted, 0 if none were
+
+// Reduced sets are put together in the given space, which holds one
+// less value than the input.
+int reduceInto(const SetVal *set, size_t size, int mode,
+        AcceptFun *accept, SetVal *rSet)
+{
+    // Take out each value in turn, putting back the one taken out
+    // before it
+    if (mode & EXPAND_SUPERS) {
+        for (size_t i = 1; i < size; i++) rSet[i - 1] = set[i];
+        if (accept(rSet, size - 1)) return 1;
+
+        for (size_t out = 1; out < size; out++) {
+            rSet[out - 1] = set[out - 1];
+            if (accept(rSet, size - 1)) return 1;
+        }
+    }
+
+    // Merge each pair of values back into the one they could have
+    // replaced
+    bool add = mode & EXPAND_MUT_ADD;
+    bool mul = mode & EXPAND_MUT_MUL;
+    if (add || mul) for (size_t i = 0; i < size; i++)
+        for (size_t j = i + 1; j < size; j++)
+        {
+            unsigned long minor = set[i];
+            unsigned long major = set[j];
+
+            // Sum and Difference; the sum can't be in a set if it
+            // won't fit
+            if (add) {
+                if (major <= SET_VAL_MAX - minor) if (mergePair(set,
+                        size, i, j, minor + major, accept, rSet))
+                    return 1;
+                if (mergePair(set, size, i, j, major - minor,
+                        accept, rSet)) return 1;
+            }
+
+            // Product and Quotient, which are the same for a factor of
+            // one; the product can't be in a set if it won't fit
+            if (mul) {
+                if (major <= SET_VAL_MAX / minor) if (mergePair(set,
+                        size, i, j, minor * major, accept, rSet))
+                    return 1;
+                if (minor > 1 && major % minor == 0) if (mergePair(set,
+                        size, i, j, major / minor, accept, rSet))
+                    return 1;
+            }
+        }
+
+    return 0;
+}
+
+// Merge Pair in Set, Check Acceptance
+bool mergePair(const SetVal *set, size_t size, size_t i, size_t j,
+        unsigned long merged, AcceptFun *accept, SetVal *rSet)
+{
+    // Can't be in a set
+    if (merged > SET_VAL_MAX) return false;
+
+    // Copy the other values, putting the merged one in order; exit if
+    // that'll create a double value
+    size_t rIndex = 0;
+    for (size_t index = 0; index < size; index++)
+    {
+        if (index == i || index == j) continue;
+
+        if (merged != 0 && merged <= set[index]) {
+            if (merged == set[index]) return false;
+            rSet[rIndex++] = merged;
+            merged = 0;
+        }
+        rSet[rIndex++] = set[index];
+    }
+
+    // Put the merged value in if we haven't already
+    if (merged != 0) rSet[rIndex++] = merged;
+
+    return accept(rSet, size - 1);
+}
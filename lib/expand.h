@@ -5,13 +5,21 @@
 #ifndef EXPAND_H
 #define EXPAND_H
 
+#include <stdbool.h>
+
+#include "setVal.h"
+
 #define EXPAND_SUPERS 1 << 0
 #define EXPAND_MUT_ADD 1 << 1
 #define EXPAND_MUT_MUL 1 << 2
 
 // Produce All Set Expansions
-int expand(const unsigned long *, size_t,
+int expand(const SetVal *, size_t,
         unsigned long, unsigned long, int,
-        void (*)(const unsigned long *, size_t));
+        void (*)(const SetVal *, size_t));
+
+// Produce Set Reductions until One is Accepted
+int reduce(const SetVal *, size_t, int,
+        bool (*)(const SetVal *, size_t));
 
 #endif
@@ -7,13 +7,25 @@
 // I/O and Command-Line Argument stuff. Needs to be linked with every
 // utility program.
 
+// Checkpoints are kept so a long run can be picked up again after it's
+// stopped, whether it crashed or was killed. A checkpoint is the record
+// being worked on, plus a small file next to it with the index of the
+// first set the scan hadn't finished with. The record goes first: marks
+// only ever get added, so a record that's ahead of its note is fine to
+// resume from, it just means redoing a little. Where the record's file
+// is already there, only the blocks that changed are written over it,
+// which leaves every block either as it was or as it is, and either is
+// fine for the same reason. Otherwise, it's written whole to a new file
+// and moved into place, as is the note, so whatever's under either name
+// is always whole.
+
+#define _DEFAULT_SOURCE
+
 #include <stdarg.h>
-#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 
 #include <errno.h>
-#include <fcntl.h>
 #include <pthread.h>
 #include <string.h>
 #include <unistd.h>
@@ -21,6 +33,10 @@
 #include "iface.h"
 #include "setRec.h"
 
+// Helper Function Declarations
+static int commitFile(FILE *, const char *, const char *);
+static int updateFile(SR_Base *, char *);
+
 // Open Record File and Import
 // Returns 0 on success, 1 on error
 int openImport(SR_Base *rec, char *fname)
@@ -51,6 +67,71 @@ int openImport(SR_Base *rec, char *fname)
     return res != 0;
 }
 
+// Open Record File and Merge it In
+// Returns 0 on success, 1 on error
+int openMerge(SR_Base *rec, char *fname)
+{
+    // Open File
+    FILE *f = fopen(fname, "rb");
+    if (f == NULL) {
+        fprintf(stderr, "Error on Opening '%s': %s\n",
+                fname, strerror(errno));
+        return 1;
+    }
+
+    // Merge Record
+    int res = sr_merge(rec, f);
+    if (res) {
+        if (res == -1)
+            fprintf(stderr, "Error on Merging '%s': %s\n",
+                    fname, strerror(errno));
+        else if (res == -2)
+            fprintf(stderr, "Error on Merging '%s': %s\n",
+                    fname, "Different Record");
+        else if (res == -3)
+            fprintf(stderr, "Error on Merging '%s': %s\n",
+                    fname, "Invalid Record File");
+    }
+
+    fclose(f);
+    return res != 0;
+}
+
+// Open Record File and Copy Marks from it
+// Returns 0 on success, 1 on error
+
+// Notes where the record's sets that were in the file's start, and how
+// many there were.
+int openRetile(SR_Base *rec, char *fname, size_t *start, size_t *covered)
+{
+    // Open File
+    FILE *f = fopen(fname, "rb");
+    if (f == NULL) {
+        fprintf(stderr, "Error on Opening '%s': %s\n",
+                fname, strerror(errno));
+        return 1;
+    }
+
+    // Copy Marks
+    *start = 0;
+    ssize_t res = sr_retile(rec, f, start);
+    if (res < 0) {
+        if (res == -1)
+            fprintf(stderr, "Error on Copying '%s': %s\n",
+                    fname, strerror(errno));
+        else if (res == -2)
+            fprintf(stderr, "Error on Copying '%s': %s\n",
+                    fname, "Different Size or Tested Range");
+        else if (res == -3)
+            fprintf(stderr, "Error on Copying '%s': %s\n",
+                    fname, "Invalid Record File");
+    }
+    else *covered = res;
+
+    fclose(f);
+    return res < 0;
+}
+
 // Open File and Export Record
 // Returns 0 on success, 1 on error
 int openExport(SR_Base *rec, char *fname)
@@ -73,25 +154,133 @@ int openExport(SR_Base *rec, char *fname)
     return res != 0;
 }
 
-// Push Progress Update
+// Open File and Export Changes to Record
+// Returns 0 on success, 1 on error
+
+// Writes only what's changed over the file the record came from, or
+// was last exported to, or the whole record if the file isn't there,
+// holds some other record, or can't be patched safely.
+int openUpdate(SR_Base *rec, char *fname)
+{
+    int res = updateFile(rec, fname);
+    if (res == 2) res = openExport(rec, fname);
+
+    return res;
+}
+
+// Save a Checkpoint
+// Returns 0 on success, 1 on error
+
+// Writes the record out under the given name, and notes the index of the
+// next set to go through in the checkpoint file beside it.
+int saveCheckpoint(SR_Base *rec, char *fname, size_t next)
+{
+    size_t len = strlen(fname);
+    char tmp[len + 10], ckpt[len + 10];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", fname);
+    snprintf(ckpt, sizeof(ckpt), "%s.ckpt", fname);
+
+    // Record first, just the changes if it's already there
+    int res = updateFile(rec, fname);
+    if (res == 1) return 1;
+
+    // Or the whole thing, then moved into place
+    FILE *f;
+    if (res == 2) {
+        f = fopen(tmp, "wb");
+        if (f == NULL) {
+            fprintf(stderr, "Error on Opening '%s': %s\n",
+                    tmp, strerror(errno));
+            return 1;
+        }
+
+        res = sr_export(rec, f);
+        if (res) fclose(f);
+        else res = commitFile(f, tmp, fname);
+
+        if (res) {
+            fprintf(stderr, "Error on Checkpointing '%s': %s\n",
+                    fname, strerror(errno));
+            remove(tmp);
+            return 1;
+        }
+    }
+
+    // Then where we're up to
+    f = fopen(tmp, "w");
+    if (f == NULL) {
+        fprintf(stderr, "Error on Opening '%s': %s\n",
+                tmp, strerror(errno));
+        return 1;
+    }
+
+    fprintf(f, "Checkpoint -- Next Set: %zu; Record Sets: %zu\n",
+            next, sr_getTotal(rec));
+    if (commitFile(f, tmp, ckpt)) {
+        fprintf(stderr, "Error on Checkpointing '%s': %s\n",
+                ckpt, strerror(errno));
+        remove(tmp);
+        return 1;
+    }
+
+    return 0;
+}
+
+// Load a Checkpoint
 // Returns 0 on success, 1 on error
-int pushProg(size_t prog, size_t total, size_t output, char *fname)
+
+// Reads the index of the next set to go through from the checkpoint
+// file beside the given record, which should already be imported, and
+// makes sure the checkpoint was of a record that size. With no
+// checkpoint file, that's the very first set.
+int loadCheckpoint(SR_Base *rec, char *fname, size_t *next)
 {
-    int res;
+    size_t len = strlen(fname);
+    char ckpt[len + 10];
+    snprintf(ckpt, sizeof(ckpt), "%s.ckpt", fname);
+
+    *next = 0;
+
+    // Open File
+    FILE *f = fopen(ckpt, "r");
+    if (f == NULL) {
+        if (errno == ENOENT) return 0;
+        fprintf(stderr, "Error on Opening '%s': %s\n",
+                ckpt, strerror(errno));
+        return 1;
+    }
+
+    // Read it, and make sure it goes with the record
+    size_t total;
+    int res = fscanf(f, "Checkpoint -- Next Set: %zu; Record Sets: %zu",
+            next, &total);
+    fclose(f);
+
+    if (res != 2 || total != sr_getTotal(rec)) {
+        fprintf(stderr, "Error on Loading '%s': %s\n",
+                ckpt, "Doesn't Match Record");
+        return 1;
+    }
 
-    // Raw Number Buffers, Fixed Size
-    uint64_t buf[3] = {prog, total, output};
+    return 0;
+}
 
-    // Open Progress File
-    int fd = open(fname, O_WRONLY | O_TRUNC);
-    if (fd < 0) return 1;
+// Remove a Checkpoint
+// Returns 0 on success, 1 on error
 
-    // Output Progress and Close
-    res = write(fd, buf, sizeof(buf));
-    if (res != sizeof(buf)) return 1;
+// Once a run's done, the record stands on its own, so only the file
+// noting where it was up to goes.
+int clearCheckpoint(char *fname)
+{
+    size_t len = strlen(fname);
+    char ckpt[len + 10];
+    snprintf(ckpt, sizeof(ckpt), "%s.ckpt", fname);
 
-    res = close(fd);
-    if (res == -1) return 1;
+    if (remove(ckpt) && errno != ENOENT) {
+        fprintf(stderr, "Error on Removing '%s': %s\n",
+                ckpt, strerror(errno));
+        return 1;
+    }
 
     return 0;
 }
@@ -222,6 +411,39 @@ int optHandle(const char *opts, _Bool setting, const char *usage,
     return 0;
 }
 
+// Handle a Shard Argument
+// Returns 0 on success, 1 on invalid shard
+
+// For splitting a run between processes. The shard is given as the last
+// argument, like 2/4, the third of four (counting from zero), and it's
+// taken off the end, so the rest can be parsed as usual.
+int shardParse(const char *usage, int *argc, char **argv,
+        size_t *shard, size_t *shards)
+{
+    if (*argc < 3) goto invalid;
+    char *arg = argv[*argc - 1];
+
+    // Both numbers, split by a slash
+    char *endptr;
+    errno = 0;
+    *shard = strtoul(arg, &endptr, 0);
+    if (errno || endptr == arg || *endptr != '/') goto invalid;
+    arg = endptr + 1;
+    *shards = strtoul(arg, &endptr, 0);
+    if (errno || endptr == arg || *endptr != '\0') goto invalid;
+    if (*shard >= *shards) goto invalid;
+
+    (*argc)--;
+    return 0;
+
+invalid:
+    fprintf(stderr, "Invalid shard, should be like 0/4 and last\n");
+    fprintf(stderr, usage, argv[0]);
+    errno = EINVAL;
+
+    return 1;
+}
+
 // Safely Exit
 _Noreturn void safeExit(void)
 {
@@ -231,3 +453,46 @@ _Noreturn void safeExit(void)
     pthread_mutex_lock(&exitLock);
     exit(1);
 }
+
+// ============ Helper Functions
+
+// Finish Writing a File and Move it into Place
+// Returns 0 on success, -1 on error (read errno)
+
+// Makes sure it's all the way on disk before it takes the place of
+// anything under the final name. The file is closed either way.
+int commitFile(FILE *f, const char *tmp, const char *fname)
+{
+    int res = fflush(f) || fsync(fileno(f)) ? -1 : 0;
+    if (fclose(f)) res = -1;
+
+    if (res == 0) res = rename(tmp, fname);
+
+    return res;
+}
+
+// Export Changes to Record over its File
+// Returns 0 on success, 1 on error, 2 if it needs a whole export
+
+// Everything written is on disk by the time this returns.
+int updateFile(SR_Base *rec, char *fname)
+{
+    // Open File, if it's there
+    FILE *f = fopen(fname, "r+b");
+    if (f == NULL) {
+        if (errno == ENOENT) return 2;
+        fprintf(stderr, "Error on Opening '%s': %s\n",
+                fname, strerror(errno));
+        return 1;
+    }
+
+    // Export Changes
+    int res = sr_export_incremental(rec, f);
+    if (res == 0) res = fflush(f) || fsync(fileno(f)) ? -1 : 0;
+    if (res == -1)
+        fprintf(stderr, "Error on Exporting '%s': %s\n",
+                fname, strerror(errno));
+
+    fclose(f);
+    return res == -2 ? 2 : res != 0;
+}
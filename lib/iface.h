@@ -12,8 +12,13 @@
 
 #define NULLIF 1 << 0
 #define ONLY_SUP 1 << 1
+#define TESTED 1 << 2
+#define FRESH 1 << 3
 #define MARKED NULLIF | ONLY_SUP
 
+// Seconds Between Checkpoints
+#define CKPT_PERIOD 300
+
 #define FAULT() \
     do { \
         fprintf(stderr, "Fault at %s:%d -- %s\n", \
@@ -57,11 +62,26 @@ typedef enum ParamType {
 // Open Record File and Import
 int openImport(SR_Base *, char *);
 
+// Open Record File and Merge it In
+int openMerge(SR_Base *, char *);
+
+// Open Record File and Copy Marks from it
+int openRetile(SR_Base *, char *, size_t *, size_t *);
+
 // Open File and Export Record
 int openExport(SR_Base *, char *);
 
-// Push Progress Update
-int pushProg(size_t, size_t, size_t, char *);
+// Open File and Export Changes to Record
+int openUpdate(SR_Base *, char *);
+
+// Save a Checkpoint
+int saveCheckpoint(SR_Base *, char *, size_t);
+
+// Load a Checkpoint
+int loadCheckpoint(SR_Base *, char *, size_t *);
+
+// Remove a Checkpoint
+int clearCheckpoint(char *);
 
 // Parse Command-Line Arguments
 int argParse(const Param *, int, const char *, int, char **, ...);
@@ -69,6 +89,9 @@ int argParse(const Param *, int, const char *, int, char **, ...);
 // Handle Command-Line Options
 int optHandle(const char *, _Bool, const char *, int, char **, ...);
 
+// Handle a Shard Argument
+int shardParse(const char *, int *, char **, size_t *, size_t *);
+
 // Safely Exit
 _Noreturn void safeExit(void);
 
@@ -0,0 +1,234 @@
+// ============================== METRICS ==============================
+
+// Copyright (c) 2023, Jacob Bates
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This library is for following along with the programs that do proper
+// work while they run. Each of their threads keeps a few counters, of
+// the sets it's gone through, the sets it's produced or tested, the
+// sets it's newly marked, and the sets that passed the test, and these
+// live in a small file mapped into memory. Anything that wants to know
+// how it's going can map the same file and read them whenever it likes,
+// with no signals and nothing for the workers to do. Each thread only
+// writes to its own counters, which get a cache line to themselves, so
+// the workers don't slow each other down either.
+
+// The file starts with a header giving the number of threads, the
+// total number of sets to go through, the process, and when it started,
+// followed by the counters. The identifying word at the very start is
+// written last, so a reader never sees a half-made header. A new file
+// is always made for a run rather than reusing an old one, so anything
+// still reading an old one is left alone. With no file name, the
+// counters are only kept in memory.
+
+#define _DEFAULT_SOURCE
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "metrics.h"
+
+// Identifying Word, "SRMETRIC"
+#define MAGIC 0x43495254454D5253
+
+// Metrics Segment
+struct Metrics {
+    atomic_uint_least64_t magic;
+    uint64_t threads;
+    uint64_t pid;
+    uint64_t started;               // nanoseconds since the epoch
+    char label[32];
+    atomic_size_t total;
+    atomic_size_t unmarked;
+    atomic_bool done;
+    MT_Counters counters[];
+};
+
+// Helper Function Declarations
+static size_t segLength(size_t);
+static uint64_t now(void);
+
+// Create a Metrics Segment
+// Returns NULL on error (read errno)
+
+// Makes a new file with the given name for the counters of the given
+// number of threads, with a label for the run, and the total number of
+// sets it'll go through. Any old file by that name is replaced. With no
+// file name, the counters are only kept in memory.
+MT_Seg *mt_create(const char *fname, const char *label,
+        size_t threads, size_t total)
+{
+    size_t len = segLength(threads);
+    MT_Seg *seg;
+
+    // Just in memory
+    if (fname == NULL) {
+        seg = mmap(NULL, len, PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (seg == MAP_FAILED) return NULL;
+    }
+
+    // Or in a new file
+    else {
+        if (unlink(fname) && errno != ENOENT) return NULL;
+
+        int fd = open(fname, O_RDWR | O_CREAT | O_EXCL, 0644);
+        if (fd < 0) return NULL;
+
+        if (ftruncate(fd, len)) {
+            close(fd);
+            return NULL;
+        }
+
+        seg = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED,
+                fd, 0);
+        close(fd);
+        if (seg == MAP_FAILED) return NULL;
+    }
+
+    // Fill in the header, identifying word last
+    seg->threads = threads;
+    seg->pid = getpid();
+    seg->started = now();
+    strncpy(seg->label, label, sizeof(seg->label) - 1);
+    atomic_store(&seg->total, total);
+    atomic_store(&seg->unmarked, 0);
+    atomic_store(&seg->done, false);
+    atomic_store_explicit(&seg->magic, MAGIC, memory_order_release);
+
+    return seg;
+}
+
+// Open a Metrics Segment for Reading
+// Returns NULL on error (read errno)
+
+// If the file isn't there yet, or isn't finished being made, the error
+// is ENOENT or EAGAIN, and it's worth trying again later.
+MT_Seg *mt_open(const char *fname)
+{
+    int fd = open(fname, O_RDONLY);
+    if (fd < 0) return NULL;
+
+    // Map the header first, to find out how long the whole thing is
+    struct stat st;
+    if (fstat(fd, &st)) {
+        close(fd);
+        return NULL;
+    }
+    if ((size_t) st.st_size < sizeof(MT_Seg)) {
+        close(fd);
+        errno = EAGAIN;
+        return NULL;
+    }
+
+    MT_Seg *seg = mmap(NULL, sizeof(MT_Seg), PROT_READ, MAP_SHARED,
+            fd, 0);
+    if (seg == MAP_FAILED) {
+        close(fd);
+        return NULL;
+    }
+
+    // Check it's ready and the right length
+    size_t len = 0;
+    uint64_t magic = atomic_load_explicit(&seg->magic,
+            memory_order_acquire);
+    if (magic == MAGIC) len = segLength(seg->threads);
+    munmap(seg, sizeof(MT_Seg));
+    if (len == 0 || (size_t) st.st_size < len) {
+        close(fd);
+        errno = EAGAIN;
+        return NULL;
+    }
+
+    // Then map all of it
+    seg = mmap(NULL, len, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (seg == MAP_FAILED) return NULL;
+
+    return seg;
+}
+
+// Close a Metrics Segment
+void mt_close(MT_Seg *seg)
+{
+    munmap(seg, segLength(seg->threads));
+
+    return;
+}
+
+// Get the Counters for a Thread
+MT_Counters *mt_counters(MT_Seg *seg, size_t thread)
+{
+    return seg->counters + thread;
+}
+
+// Note the Count of Unmarked Sets
+void mt_setUnmarked(MT_Seg *seg, size_t unmarked)
+{
+    atomic_store(&seg->unmarked, unmarked);
+
+    return;
+}
+
+// Note the Run is Finished
+void mt_finish(MT_Seg *seg)
+{
+    atomic_store(&seg->done, true);
+
+    return;
+}
+
+// Read the Sum of All Counters
+void mt_read(const MT_Seg *seg, MT_Totals *totals)
+{
+    memcpy(totals->label, seg->label, sizeof(totals->label));
+    totals->label[sizeof(totals->label) - 1] = '\0';
+    totals->threads = seg->threads;
+    totals->pid = seg->pid;
+    totals->elapsed = (now() - seg->started) / 1e9;
+    totals->total = atomic_load(&seg->total);
+    totals->unmarked = atomic_load(&seg->unmarked);
+    totals->done = atomic_load(&seg->done);
+
+    totals->scanned = 0;
+    totals->outputs = 0;
+    totals->marks = 0;
+    totals->passes = 0;
+    for (size_t i = 0; i < seg->threads; i++) {
+        const MT_Counters *c = seg->counters + i;
+        totals->scanned += atomic_load(&c->scanned);
+        totals->outputs += atomic_load(&c->outputs);
+        totals->marks += atomic_load(&c->marks);
+        totals->passes += atomic_load(&c->passes);
+    }
+
+    return;
+}
+
+// ============ Helper Functions
+
+// Length of a Segment
+// Returns the number of bytes for the given number of threads
+size_t segLength(size_t threads)
+{
+    return sizeof(MT_Seg) + threads * sizeof(MT_Counters);
+}
+
+// Current Time
+// Returns nanoseconds since the epoch
+uint64_t now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+
+    return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
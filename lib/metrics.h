@@ -0,0 +1,69 @@
+// ============================== METRICS ==============================
+
+// See more info about this library in the source file `metrics.c'.
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+// Counters for a Single Thread
+typedef struct MT_Counters {
+    _Alignas(64) atomic_size_t scanned;     // sets gone through
+    atomic_size_t outputs;                  // sets produced or tested
+    atomic_size_t marks;                    // sets newly marked
+    atomic_size_t passes;                   // sets passing the test
+} MT_Counters;
+
+// Sum of All Counters, and Details of the Run
+typedef struct MT_Totals {
+    char label[32];
+    size_t threads;
+    long pid;
+    double elapsed;                         // seconds since start
+    size_t total;
+    size_t unmarked;                        // zero if not counted
+    bool done;
+    size_t scanned;
+    size_t outputs;
+    size_t marks;
+    size_t passes;
+} MT_Totals;
+
+// Metrics Segment
+typedef struct Metrics MT_Seg;
+
+// Create a Metrics Segment
+MT_Seg *mt_create(const char *, const char *, size_t, size_t);
+
+// Open a Metrics Segment for Reading
+MT_Seg *mt_open(const char *);
+
+// Close a Metrics Segment
+void mt_close(MT_Seg *);
+
+// Get the Counters for a Thread
+MT_Counters *mt_counters(MT_Seg *, size_t);
+
+// Note the Count of Unmarked Sets
+void mt_setUnmarked(MT_Seg *, size_t);
+
+// Note the Run is Finished
+void mt_finish(MT_Seg *);
+
+// Read the Sum of All Counters
+void mt_read(const MT_Seg *, MT_Totals *);
+
+// Add to a Counter
+
+// Only the thread a counter belongs to writes to it, so there's no need
+// for a locked add, just an atomic store that readers can't tear.
+static inline void mt_add(atomic_size_t *counter, size_t n)
+{
+    size_t v = atomic_load_explicit(counter, memory_order_relaxed);
+    atomic_store_explicit(counter, v + n, memory_order_relaxed);
+}
+
+#endif
@@ -0,0 +1,222 @@
+// =================== GENERATED NULLIFIABILITY TESTS ==================
+
+// Generated by `genkernels.py', don't edit by hand. This is included in
+// `nulTest.c', which has the helper functions these use.
+
+// Test if a Length-4 Set is Nullifiable or Not
+// Returns 0 if nullifiable, 1 if innullifiable
+static int nulTest4(const unsigned long s[4],
+        unsigned long minm, unsigned long maxm)
+{
+    unsigned long m, r[4], x, y, sum, prod;
+
+    // Simple equality
+    if (s[0] == s[1] || s[0] == s[2] || s[0] == s[3]
+            || s[1] == s[2] || s[1] == s[3] || s[2] == s[3]) return 0;
+
+    // Reduce s[0] and s[1]
+    m = maxValue(s[2], s[3]);
+    if (maxm == 0 || m <= maxm) {
+        pairValues(s[0], s[1], r);
+        x = s[2], y = s[3], sum = x + y, prod = x * y;
+        for (size_t i = 0; i < 4; i++)
+            if (r[i] != 0 && inRange(r[i], m, minm, maxm))
+                if (r[i] == x || r[i] == y || r[i] == sum
+                        || r[i] == prod || r[i] + x == y
+                        || r[i] + y == x || r[i] * x == y
+                        || r[i] * y == x) return 0;
+    }
+
+    // Reduce s[0] and s[2]
+    m = maxValue(s[1], s[3]);
+    if (maxm == 0 || m <= maxm) {
+        pairValues(s[0], s[2], r);
+        x = s[1], y = s[3], sum = x + y, prod = x * y;
+        for (size_t i = 0; i < 4; i++)
+            if (r[i] != 0 && inRange(r[i], m, minm, maxm))
+                if (r[i] == x || r[i] == y || r[i] == sum
+                        || r[i] == prod || r[i] + x == y
+                        || r[i] + y == x || r[i] * x == y
+                        || r[i] * y == x) return 0;
+    }
+
+    // Reduce s[0] and s[3]
+    m = maxValue(s[1], s[2]);
+    if (maxm == 0 || m <= maxm) {
+        pairValues(s[0], s[3], r);
+        x = s[1], y = s[2], sum = x + y, prod = x * y;
+        for (size_t i = 0; i < 4; i++)
+            if (r[i] != 0 && inRange(r[i], m, minm, maxm))
+                if (r[i] == x || r[i] == y || r[i] == sum
+                        || r[i] == prod || r[i] + x == y
+                        || r[i] + y == x || r[i] * x == y
+                        || r[i] * y == x) return 0;
+    }
+
+    // Reduce s[1] and s[2]
+    m = maxValue(s[0], s[3]);
+    if (maxm == 0 || m <= maxm) {
+        pairValues(s[1], s[2], r);
+        x = s[0], y = s[3], sum = x + y, prod = x * y;
+        for (size_t i = 0; i < 4; i++)
+            if (r[i] != 0 && inRange(r[i], m, minm, maxm))
+                if (r[i] == x || r[i] == y || r[i] == sum
+                        || r[i] == prod || r[i] + x == y
+                        || r[i] + y == x || r[i] * x == y
+                        || r[i] * y == x) return 0;
+    }
+
+    // Reduce s[1] and s[3]
+    m = maxValue(s[0], s[2]);
+    if (maxm == 0 || m <= maxm) {
+        pairValues(s[1], s[3], r);
+        x = s[0], y = s[2], sum = x + y, prod = x * y;
+        for (size_t i = 0; i < 4; i++)
+            if (r[i] != 0 && inRange(r[i], m, minm, maxm))
+                if (r[i] == x || r[i] == y || r[i] == sum
+                        || r[i] == prod || r[i] + x == y
+                        || r[i] + y == x || r[i] * x == y
+                        || r[i] * y == x) return 0;
+    }
+
+    // Reduce s[2] and s[3]
+    m = maxValue(s[0], s[1]);
+    if (maxm == 0 || m <= maxm) {
+        pairValues(s[2], s[3], r);
+        x = s[0], y = s[1], sum = x + y, prod = x * y;
+        for (size_t i = 0; i < 4; i++)
+            if (r[i] != 0 && inRange(r[i], m, minm, maxm))
+                if (r[i] == x || r[i] == y || r[i] == sum
+                        || r[i] == prod || r[i] + x == y
+                        || r[i] + y == x || r[i] * x == y
+                        || r[i] * y == x) return 0;
+    }
+
+    return 1;
+}
+
+// Test if a Length-5 Set is Nullifiable or Not
+// Returns 0 if nullifiable, 1 if innullifiable
+static int nulTest5(const unsigned long s[5],
+        unsigned long minm, unsigned long maxm)
+{
+    unsigned long m, r[4];
+
+    // Simple equality
+    if (s[0] == s[1] || s[0] == s[2] || s[0] == s[3]
+            || s[0] == s[4] || s[1] == s[2] || s[1] == s[3]
+            || s[1] == s[4] || s[2] == s[3] || s[2] == s[4]
+            || s[3] == s[4]) return 0;
+
+    // Reduce s[0] and s[1]
+    m = maxValue(maxValue(s[2], s[3]), s[4]);
+    if (maxm == 0 || m <= maxm) {
+        pairValues(s[0], s[1], r);
+        for (size_t i = 0; i < 4; i++)
+            if (r[i] != 0 && inRange(r[i], m, minm, maxm)) {
+                const unsigned long t[4] = {r[i], s[2], s[3], s[4]};
+                if (nulTest4(t, 0, 0) == 0) return 0;
+            }
+    }
+
+    // Reduce s[0] and s[2]
+    m = maxValue(maxValue(s[1], s[3]), s[4]);
+    if (maxm == 0 || m <= maxm) {
+        pairValues(s[0], s[2], r);
+        for (size_t i = 0; i < 4; i++)
+            if (r[i] != 0 && inRange(r[i], m, minm, maxm)) {
+                const unsigned long t[4] = {r[i], s[1], s[3], s[4]};
+                if (nulTest4(t, 0, 0) == 0) return 0;
+            }
+    }
+
+    // Reduce s[0] and s[3]
+    m = maxValue(maxValue(s[1], s[2]), s[4]);
+    if (maxm == 0 || m <= maxm) {
+        pairValues(s[0], s[3], r);
+        for (size_t i = 0; i < 4; i++)
+            if (r[i] != 0 && inRange(r[i], m, minm, maxm)) {
+                const unsigned long t[4] = {r[i], s[1], s[2], s[4]};
+                if (nulTest4(t, 0, 0) == 0) return 0;
+            }
+    }
+
+    // Reduce s[0] and s[4]
+    m = maxValue(maxValue(s[1], s[2]), s[3]);
+    if (maxm == 0 || m <= maxm) {
+        pairValues(s[0], s[4], r);
+        for (size_t i = 0; i < 4; i++)
+            if (r[i] != 0 && inRange(r[i], m, minm, maxm)) {
+                const unsigned long t[4] = {r[i], s[1], s[2], s[3]};
+                if (nulTest4(t, 0, 0) == 0) return 0;
+            }
+    }
+
+    // Reduce s[1] and s[2]
+    m = maxValue(maxValue(s[0], s[3]), s[4]);
+    if (maxm == 0 || m <= maxm) {
+        pairValues(s[1], s[2], r);
+        for (size_t i = 0; i < 4; i++)
+            if (r[i] != 0 && inRange(r[i], m, minm, maxm)) {
+                const unsigned long t[4] = {r[i], s[0], s[3], s[4]};
+                if (nulTest4(t, 0, 0) == 0) return 0;
+            }
+    }
+
+    // Reduce s[1] and s[3]
+    m = maxValue(maxValue(s[0], s[2]), s[4]);
+    if (maxm == 0 || m <= maxm) {
+        pairValues(s[1], s[3], r);
+        for (size_t i = 0; i < 4; i++)
+            if (r[i] != 0 && inRange(r[i], m, minm, maxm)) {
+                const unsigned long t[4] = {r[i], s[0], s[2], s[4]};
+                if (nulTest4(t, 0, 0) == 0) return 0;
+            }
+    }
+
+    // Reduce s[1] and s[4]
+    m = maxValue(maxValue(s[0], s[2]), s[3]);
+    if (maxm == 0 || m <= maxm) {
+        pairValues(s[1], s[4], r);
+        for (size_t i = 0; i < 4; i++)
+            if (r[i] != 0 && inRange(r[i], m, minm, maxm)) {
+                const unsigned long t[4] = {r[i], s[0], s[2], s[3]};
+                if (nulTest4(t, 0, 0) == 0) return 0;
+            }
+    }
+
+    // Reduce s[2] and s[3]
+    m = maxValue(maxValue(s[0], s[1]), s[4]);
+    if (maxm == 0 || m <= maxm) {
+        pairValues(s[2], s[3], r);
+        for (size_t i = 0; i < 4; i++)
+            if (r[i] != 0 && inRange(r[i], m, minm, maxm)) {
+                const unsigned long t[4] = {r[i], s[0], s[1], s[4]};
+                if (nulTest4(t, 0, 0) == 0) return 0;
+            }
+    }
+
+    // Reduce s[2] and s[4]
+    m = maxValue(maxValue(s[0], s[1]), s[3]);
+    if (maxm == 0 || m <= maxm) {
+        pairValues(s[2], s[4], r);
+        for (size_t i = 0; i < 4; i++)
+            if (r[i] != 0 && inRange(r[i], m, minm, maxm)) {
+                const unsigned long t[4] = {r[i], s[0], s[1], s[3]};
+                if (nulTest4(t, 0, 0) == 0) return 0;
+            }
+    }
+
+    // Reduce s[3] and s[4]
+    m = maxValue(maxValue(s[0], s[1]), s[2]);
+    if (maxm == 0 || m <= maxm) {
+        pairValues(s[3], s[4], r);
+        for (size_t i = 0; i < 4; i++)
+            if (r[i] != 0 && inRange(r[i], m, minm, maxm)) {
+                const unsigned long t[4] = {r[i], s[0], s[1], s[2]};
+                if (nulTest4(t, 0, 0) == 0) return 0;
+            }
+    }
+
+    return 1;
+}
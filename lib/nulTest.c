@@ -9,25 +9,233 @@
 // frames exist for the smaller sets than the larger ones, so my idea
 // right now is just to work on optimizing for those smaller sets.
 
-#include <stdlib.h>
+// There's also an incremental variant, for testing many sets in a row
+// where neighbouring sets share most of their values, such as when
+// going through a record in order. It takes a different approach: a
+// set with some lowest value X and the rest of its values T is
+// nullifiable exactly when T is nullifiable, or X itself can be made
+// out of some of the values in T (then X minus that is zero). So for
+// each level of T, going down from the top value, it keeps the values
+// every subset can be made into, and the union of them all. The values
+// of all of T together would be the biggest list by far, so those
+// aren't worked out until T is part of something larger; instead, it
+// checks X against each way of splitting T in two. These only depend
+// on the values in T, and since records are ordered by their highest
+// values, consecutive sets share their top values, so when the next
+// set comes along, only the levels below the values that changed
+// need to be worked out again. Most of the time, only X changes, and
+// the test is a single lookup. Values that aren't too large are kept in
+// bitsets, so unions are ORs and sums and differences are shifted ORs,
+// while larger values go in sorted lists. This only covers the test
+// with no initial reduction range; ranged tests are passed on to the
+// usual test.
+
+// Length-4 and length-5 sets are tested with code generated by
+// `genkernels.py', which goes about it the same way as the recursion,
+// only spelled out, without any allocation. Length-5 sets met while
+// recursing go there too.
+
+// An oracle can be given for reduced sets of one size, which knows
+// about some of them already, like a record of that size that's been
+// swept. Reduced sets it knows about are looked up rather than tested,
+// and the others are tested as usual. This only applies to the usual
+// test, not the incremental one.
+
+// The incremental test can also use a cache of the values small sets of
+// up to four values can be made into, keyed by the values themselves,
+// so it's shared across threads and sets. It can be filled in for every
+// set up to some M-value from the start, and other sets get added as
+// they come up, until it's full.
+
+#include <limits.h>
+#include <stdatomic.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <errno.h>
+
+#include "bitset.h"
+#include "nulTest.h"
+
+// Largest Set Size for Incremental Testing, and Largest Value Kept in
+// its Bitsets (8K each)
+#define INC_MAX 20
+#define INC_LIMIT 0xFFFF
+
+// Largest Set Size with its Own Recursive Test, Function Attributes for
+// the Shared Body
+#define KERN_MAX 12
+#define KERNEL static inline __attribute__((always_inline))
+
+// Recursive Test, for One Size or Any
+typedef int Recursive(const unsigned long *, size_t,
+        unsigned long, unsigned long);
+
+// Set of Values
+
+// Values up to the context's limit are kept in a bitset, so that adding
+// and looking up values is direct, and any above are kept in a list.
+typedef struct Values Values;
+struct Values {
+    uint64_t *bits;         // values up to the limit
+    unsigned long *v;       // values above the limit, ascending
+    size_t len;
+    size_t cap;
+    size_t count;           // total number of values
+};
+
+// Cached Values of a Small Set
+typedef struct CacheEntry CacheEntry;
+struct CacheEntry {
+    uint64_t key;           // values of the set, 16 bits each
+    size_t len;
+    unsigned long v[];      // values it can be made into, ascending
+};
+
+// Largest Set Size and Value for the Cache
+#define CACHE_SIZE 4
+#define CACHE_VAL 0xFFFF
+
+// Cache of Reachable Values
+
+// Open addressing, with twice as many slots as entries allowed, so it
+// never fills up. Entries are only added, never changed or removed,
+// until it's released.
+static struct {
+    _Atomic(CacheEntry *) *slots;
+    size_t mask;                    // slot count minus one
+    size_t max;                     // entries allowed
+    atomic_size_t count;
+} cache = {NULL, 0, 0, 0};
+
+// Oracle for Reduced Sets, and their Size
+static struct {
+    NT_Oracle *look;
+    size_t size;
+} oracle = {NULL, 0};
+
+// Incremental Testing Context
+struct NulInc {
+    size_t maxSize;
+    size_t levels;                  // levels worked out
+    unsigned long top[INC_MAX];     // value at each level, top first
+    unsigned long limit;            // highest value for bitsets
+    size_t words;                   // words per bitset
+    size_t built;                   // levels with bitsets so far
+    uint64_t *bitsv[INC_MAX + 1];   // backing for each level's bitsets
+    Values *reach;                  // per subset bitmask of levels
+    Values *uni;                    // union of reach, per level
+    size_t **order;                 // new subsets per level
+    Values buf;                     // scratch
+};
+
+// Helper Function Declarations
+static const CacheEntry *cacheGet(const unsigned long *, size_t);
+static CacheEntry *cacheCompute(const unsigned long *, size_t, uint64_t);
+
+static inline void pairValues(unsigned long, unsigned long,
+        unsigned long [4]);
+static inline bool inRange(unsigned long, unsigned long,
+        unsigned long, unsigned long);
+static inline unsigned long maxValue(unsigned long, unsigned long);
+
+static int addLevel(NT_Inc *, size_t);
+static int reachOf(NT_Inc *, size_t);
+static bool reachable(const NT_Inc *, size_t, unsigned long);
+
+static void clearValues(const NT_Inc *, Values *);
+static int addValue(const NT_Inc *, Values *, unsigned long);
+static void finishValues(const NT_Inc *, Values *);
+static bool hasValue(const NT_Inc *, const Values *, unsigned long);
+static unsigned long nextValue(const NT_Inc *, const Values *,
+        size_t *);
+static int pushValue(Values *, unsigned long);
+static int buildLevel(NT_Inc *, size_t);
+static int cmpValue(const void *, const void *);
+
+static int testWide(const unsigned long *, size_t,
+        unsigned long, unsigned long);
+KERNEL int testSized(const unsigned long *, size_t,
+        unsigned long, unsigned long, unsigned long *, Recursive *);
+
+// Generated Tests for Length-4 and Length-5 Sets
+#include "nulKernels.h"
+
+// ============ Kernels
+
+// The recursive test is made again for each size from 6 up to a point,
+// with the size fixed, so its loops can be unrolled and the smaller set
+// kept on the stack, and each one calls the next size down directly,
+// down to the generated test for length-5 sets. Any larger size uses
+// the general one until it gets down to these.
+
+static int recursiveTest5(const unsigned long *set, size_t size,
+        unsigned long minm, unsigned long maxm)
+{
+    (void) size;
+    return nulTest5(set, minm, maxm);
+}
+
+#define KERNELS(N, M) \
+    static int recursiveTest##N(const unsigned long *set, size_t size, \
+            unsigned long minm, unsigned long maxm) \
+    { \
+        (void) size; \
+        unsigned long newSet[N - 1]; \
+        return testSized(set, N, minm, maxm, newSet, \
+                &recursiveTest##M); \
+    }
+
+KERNELS(6, 5) KERNELS(7, 6) KERNELS(8, 7) KERNELS(9, 8)
+KERNELS(10, 9) KERNELS(11, 10) KERNELS(12, 11)
+
+// Kernels by Set Size, from Length-5
+static Recursive *const kernels[KERN_MAX + 1] = {
+    [5] = &recursiveTest5, &recursiveTest6, &recursiveTest7,
+    &recursiveTest8, &recursiveTest9, &recursiveTest10,
+    &recursiveTest11, &recursiveTest12
+};
+
+// ============ User-Level Functions
 
 // Test if a set is Nullifiable or Not
 // Returns 0 if nullifiable, 1 if innullifiable, -1 on memory error
-int nulTest(const unsigned long *set, size_t size,
+int nulTest(const SetVal *set, size_t size,
         unsigned long minm, unsigned long maxm)
 {
-    int recursiveTest(const unsigned long *, size_t,
-            unsigned long, unsigned long);
+    // The tests work on full-width values, as operating on values makes
+    // them larger than any in a set; on the stack unless it's large
+    unsigned long stack[KERN_MAX];
+    unsigned long *wide = stack;
+    if (size > KERN_MAX) {
+        wide = calloc(size, sizeof(unsigned long));
+        if (wide == NULL) return -1;
+    }
+    for (size_t i = 0; i < size; i++) wide[i] = set[i];
 
-    // Simple cases to not use recursion on
-    if (size == 0) return 1;
-    if (size == 1) return set[0] != 0;
-    if (size == 2) return set[0] != set[1];
-    for (size_t i = 0; i < size; i++) if (set[i] == 0) return 0;
+    int res = testWide(wide, size, minm, maxm);
 
-    // Use recursion
-    return recursiveTest(set, size, minm, maxm);
+    if (wide != stack) free(wide);
+
+    return res;
+}
+
+// Set an Oracle for Reduced Sets of One Size
+
+// From then on, whenever the test reduces a set down to the given size,
+// the oracle is asked about it first. It returns 0 if the set's known
+// to be nullifiable, 1 if it's known to be innullifiable, NT_UNKNOWN if
+// it isn't known, or -1 on error. The values it gets are in no
+// particular order, and may be doubled. It has to be safe to call from
+// every thread testing at once. A null oracle takes it away. This isn't
+// meant to be done while testing.
+void nt_setOracle(size_t size, NT_Oracle *look)
+{
+    oracle.look = look;
+    oracle.size = look != NULL ? size : 0;
+
+    return;
 }
 
 // Test if a Length-3 Set is Nullifiable or Not
@@ -81,6 +289,60 @@ int recursiveTest(const unsigned long *set, size_t size,
     // Base case
     if (size == 3) return nulTestTriplet(set);
 
+    // Allocate Space for New Set
+    unsigned long *newSet = calloc(size - 1, sizeof(unsigned long));
+    if (newSet == NULL) return -1;
+
+    // Recurse on the sizes with their own kernel, from length-5
+    Recursive *next = &recursiveTest;
+    if (size - 1 >= 5 && size - 1 <= KERN_MAX) next = kernels[size - 1];
+
+    int res = testSized(set, size, minm, maxm, newSet, next);
+    free(newSet);
+
+    return res;
+}
+
+// ============ Helper Functions
+
+// Test if a Set of Full-Width Values is Nullifiable or Not
+// Returns 0 if nullifiable, 1 if innullifiable, -1 on memory error
+int testWide(const unsigned long *set, size_t size,
+        unsigned long minm, unsigned long maxm)
+{
+    int recursiveTest(const unsigned long *, size_t,
+            unsigned long, unsigned long);
+
+    // Simple cases to not use recursion on
+    if (size == 0) return 1;
+    if (size == 1) return set[0] != 0;
+    if (size == 2) return set[0] != set[1];
+    for (size_t i = 0; i < size; i++) if (set[i] == 0) return 0;
+
+    // The generated tests don't reduce a set one step at a time, so
+    // sets that reduce to the oracle's size go through the recursion
+    if (oracle.look != NULL && size == oracle.size + 1 && size <= 5)
+        return recursiveTest(set, size, minm, maxm);
+
+    // Small sets have their own tests
+    if (size == 4) return nulTest4(set, minm, maxm);
+    if (size >= 5 && size <= KERN_MAX)
+        return kernels[size](set, size, minm, maxm);
+
+    // Use recursion
+    return recursiveTest(set, size, minm, maxm);
+}
+
+// Test a Set of a Known Size Recursively
+// Returns 0 if nullifiable, 1 if innullifiable, -1 on memory error
+
+// The body of the recursive test, for sets of size 4 or larger. Smaller
+// sets are put together in the given space, which holds one less value
+// than the set, and handed to the given test.
+int testSized(const unsigned long *set, size_t size,
+        unsigned long minm, unsigned long maxm, unsigned long *newSet,
+        Recursive *next)
+{
     // Pass over every pair of values, checking for simple equality
     for (size_t pairA = 0; pairA < size; pairA++)
         for (size_t pairB = pairA + 1; pairB < size; pairB++)
@@ -92,10 +354,6 @@ int recursiveTest(const unsigned long *set, size_t size,
     // in that new 'set' to ourselves. If we can show nullifiability at
     // any point, that carries on
 
-    // Allocate Space for New Set
-    unsigned long *newSet = calloc(size - 1, sizeof(unsigned long));
-    if (newSet == NULL) return -1;
-
     // Iterate through all the possible pairs of values
     for (size_t pairA = 0; pairA < size; pairA++)
         for (size_t pairB = pairA + 1; pairB < size; pairB++)
@@ -115,14 +373,16 @@ int recursiveTest(const unsigned long *set, size_t size,
         if (mval > maxm && maxm != 0) continue;
 
         // Get the values of that pair
-        unsigned int a = set[pairA];
-        unsigned int b = set[pairB];
+        unsigned long a = set[pairA];
+        unsigned long b = set[pairB];
 
         // List all the possible results obtained from performing
-        // arithmetic operations on them, or replacement values
+        // arithmetic operations on them, or replacement values; a sum
+        // or product too large to hold is left out, rather than let it
+        // wrap around into some other value
         unsigned long replacements[4] = {0};
-        replacements[1] = a + b;
-        replacements[3] = a * b;
+        if (a <= ULONG_MAX - b) replacements[1] = a + b;
+        if (a <= ULONG_MAX / b) replacements[3] = a * b;
 
         // There is one difference (won't generate a zero as we've
         // already scanned for equality)
@@ -147,20 +407,727 @@ int recursiveTest(const unsigned long *set, size_t size,
             // Place into the new set
             newSet[0] = replacements[i];
 
-            // Recurse on this set, no more initial reduction space
-            int res = recursiveTest(newSet, size - 1, 0, 0);
+            // Ask the oracle if it knows, or recurse on this set, no
+            // more initial reduction space
+            int res = NT_UNKNOWN;
+            if (oracle.size == size - 1)
+                res = oracle.look(newSet, size - 1);
+            if (res == NT_UNKNOWN) res = next(newSet, size - 1, 0, 0);
 
             // If we get an error or if it's been nullified, carry that
             // on
-            if (res != 1) {
-                free(newSet);
-                return res;
-            }
+            if (res != 1) return res;
         }
     }
 
     // If we haven't shown nullifiability at any stage, the set is
     // innullifiable
-    free(newSet);
     return 1;
 }
+
+// ============ Generated Test Helpers
+
+// Values from Reducing a Pair
+
+// Lists the sum, the difference, the product and the quotient of two
+// values, just like the recursive test, with zero for no quotient, and
+// for a sum or product too large to hold.
+void pairValues(unsigned long a, unsigned long b, unsigned long r[4])
+{
+    r[0] = a > b ? a - b : b - a;
+    r[1] = a <= ULONG_MAX - b ? a + b : 0;
+    r[2] = a % b == 0 ? a / b : b % a == 0 ? b / a : 0;
+    r[3] = a <= ULONG_MAX / b ? a * b : 0;
+
+    return;
+}
+
+// Check a Reduction Against the Initial Range
+
+// Given the value from reducing a pair and the highest value left, just
+// like the recursive test.
+bool inRange(unsigned long r, unsigned long m,
+        unsigned long minm, unsigned long maxm)
+{
+    if (r > maxm && maxm != 0) return false;
+    if (m < minm && r < minm) return false;
+    return true;
+}
+
+// Larger of Two Values
+unsigned long maxValue(unsigned long a, unsigned long b)
+{
+    return a > b ? a : b;
+}
+
+// ============ Cache of Reachable Values
+
+// Set up the Cache of Reachable Values
+// Returns 0 on success, -1 on error (read errno)
+
+// Allows the cache to hold up to the given number of sets, and fills it
+// in for every innullifiable set of two to four values up to the given
+// M-value, which can be zero to fill it in only as sets come up. Call
+// this before any testing starts, not while threads are testing.
+int nt_initCache(unsigned long premax, size_t entries)
+{
+    nt_releaseCache();
+
+    // Slots for twice the entries, rounded up to a power of two
+    size_t slots = 0x10;
+    while (slots < entries * 2) slots <<= 1;
+    cache.slots = calloc(slots, sizeof(*cache.slots));
+    if (cache.slots == NULL) return -1;
+    cache.mask = slots - 1;
+    cache.max = entries;
+    atomic_init(&cache.count, 0);
+
+    // Go through sets up to the M-value in order
+    if (premax > CACHE_VAL) premax = CACHE_VAL;
+    for (size_t size = 2; size <= CACHE_SIZE; size++)
+    {
+        unsigned long set[CACHE_SIZE];
+        for (size_t i = 0; i < size; i++) set[i] = i + 1;
+
+        while (set[size - 1] <= premax)
+        {
+            if (testWide(set, size, 0, 0) == 1)
+                if (cacheGet(set, size) == NULL && errno) return -1;
+
+            // Next set in order
+            size_t i = 0;
+            while (i < size - 1 && set[i] + 1 == set[i + 1]) i++;
+            set[i]++;
+            for (size_t j = 0; j < i; j++) set[j] = j + 1;
+        }
+    }
+
+    return 0;
+}
+
+// Release the Cache of Reachable Values
+void nt_releaseCache(void)
+{
+    if (cache.slots != NULL)
+        for (size_t i = 0; i <= cache.mask; i++)
+            free(atomic_load(cache.slots + i));
+
+    free(cache.slots);
+    cache.slots = NULL;
+    cache.mask = 0;
+    cache.max = 0;
+
+    return;
+}
+
+// Get the Values a Small Set can be Made Into
+// Returns the entry, or NULL if it isn't cached (errno set on error)
+
+// Takes two to four values in ascending order. If the set isn't in the
+// cache yet, it's worked out and added, unless the cache is full, or
+// the values are too big to be keyed.
+const CacheEntry *cacheGet(const unsigned long *set, size_t size)
+{
+    errno = 0;
+    if (cache.slots == NULL || size < 2 || size > CACHE_SIZE) return NULL;
+
+    // Pack the values into the key
+    uint64_t key = 0;
+    for (size_t i = 0; i < size; i++) {
+        if (set[i] == 0 || set[i] > CACHE_VAL) return NULL;
+        key = key << 16 | set[i];
+    }
+
+    // Look through the slots from where the key hashes to
+    size_t slot = (key * 0x9E3779B97F4A7C15) >> 32 & cache.mask;
+    CacheEntry *made = NULL;
+    for (;; slot = (slot + 1) & cache.mask)
+    {
+        CacheEntry *entry = atomic_load_explicit(cache.slots + slot,
+                memory_order_acquire);
+        if (entry != NULL) {
+            if (entry->key == key) {
+                free(made);
+                return entry;
+            }
+            continue;
+        }
+
+        // Not there, so work it out, if there's still room
+        if (made == NULL) {
+            if (atomic_fetch_add(&cache.count, 1) >= cache.max) {
+                atomic_fetch_sub(&cache.count, 1);
+                return NULL;
+            }
+            made = cacheCompute(set, size, key);
+            if (made == NULL) {
+                atomic_fetch_sub(&cache.count, 1);
+                return NULL;
+            }
+        }
+
+        // Another thread may have taken the slot in the meantime
+        if (atomic_compare_exchange_strong_explicit(cache.slots + slot,
+                &entry, made, memory_order_release, memory_order_acquire))
+            return made;
+        if (entry->key == key) {
+            atomic_fetch_sub(&cache.count, 1);
+            free(made);
+            return entry;
+        }
+    }
+}
+
+// Work Out the Values a Small Set can be Made Into
+// Returns a new entry, or NULL on memory error
+
+// Goes through every subset from smallest bitmask up, working out its
+// values from the ways of splitting it in two, just like the
+// incremental test does, only with plain lists.
+CacheEntry *cacheCompute(const unsigned long *set, size_t size,
+        uint64_t key)
+{
+    Values reach[1 << CACHE_SIZE] = {0};
+    CacheEntry *entry = NULL;
+
+    size_t full = ((size_t) 1 << size) - 1;
+    for (size_t m = 1; m <= full; m++)
+    {
+        Values *r = reach + m;
+
+        // A single value can only be made into itself
+        if ((m & (m - 1)) == 0) {
+            if (pushValue(r, set[__builtin_ctzl(m)])) goto end;
+            continue;
+        }
+
+        // Otherwise every operation on values from each side of every
+        // split, counting each split once by keeping the lowest bit on
+        // one side
+        size_t low = m & -m;
+        for (size_t u = (m - 1) & m; u != 0; u = (u - 1) & m)
+        {
+            if (!(u & low)) continue;
+            const Values *a = reach + u;
+            const Values *b = reach + (m ^ u);
+
+            for (size_t i = 0; i < a->len; i++)
+                for (size_t j = 0; j < b->len; j++)
+            {
+                unsigned long x = a->v[i], y = b->v[j];
+                unsigned long res[4] = {0};
+
+                if (x <= ULONG_MAX - y) res[0] = x + y;
+                res[1] = x > y ? x - y : y - x;
+                if (x <= ULONG_MAX / y) res[2] = x * y;
+                if (x % y == 0) res[3] = x / y;
+                else if (y % x == 0) res[3] = y / x;
+
+                for (size_t k = 0; k < 4; k++)
+                    if (res[k] != 0) if (pushValue(r, res[k])) goto end;
+            }
+        }
+
+        // Sort, and remove duplicates
+        qsort(r->v, r->len, sizeof(unsigned long), &cmpValue);
+        size_t uniq = 0;
+        for (size_t i = 0; i < r->len; i++)
+            if (uniq == 0 || r->v[i] != r->v[uniq - 1])
+                r->v[uniq++] = r->v[i];
+        r->len = uniq;
+    }
+
+    // Copy those for the full set into the entry
+    Values *r = reach + full;
+    entry = malloc(sizeof(CacheEntry) + r->len * sizeof(unsigned long));
+    if (entry == NULL) goto end;
+    entry->key = key;
+    entry->len = r->len;
+    for (size_t i = 0; i < r->len; i++) entry->v[i] = r->v[i];
+
+end:
+    for (size_t m = 1; m <= full; m++) free(reach[m].v);
+
+    return entry;
+}
+
+// ============ Incremental Testing
+
+// Initialize an Incremental Testing Context
+// Returns NULL on error (read errno)
+
+// Creates a context for testing sets of up to the given size. It's not
+// to be shared between threads. Values up to the given limit are kept
+// in bitsets, which works well for something like the square of the
+// highest value in the sets; a limit of zero means no bitsets, and it's
+// capped so no bitset is more than 8K. The bitsets for each level's
+// subsets are only allocated once a set reaches that level, and there
+// are as many for a level as all the levels above it together, so the
+// memory goes with two to the power of the largest size tested.
+NT_Inc *nt_initInc(size_t maxSize, unsigned long limit)
+{
+    errno = EINVAL;
+    if (maxSize > INC_MAX) return NULL;
+    errno = 0;
+
+    // Allocate Information Structure
+    NT_Inc *inc = calloc(1, sizeof(NT_Inc));
+    if (inc == NULL) return NULL;
+
+    if (limit > INC_LIMIT) limit = INC_LIMIT;
+    inc->maxSize = maxSize;
+    inc->levels = 0;
+    inc->words = limit ? BS_WORDS(limit + 1) : 0;
+    inc->limit = limit ? inc->words * 64 - 1 : 0;
+
+    // Value sets for every subset and level, and scratch; only the
+    // union for no levels and the scratch have bitsets to start with
+    size_t subsets = (size_t) 1 << maxSize;
+    inc->reach = calloc(subsets, sizeof(Values));
+    inc->uni = calloc(maxSize + 1, sizeof(Values));
+    inc->order = calloc(maxSize + 1, sizeof(size_t *));
+    inc->bitsv[0] = calloc(2 * inc->words + 1, sizeof(uint64_t));
+    if (inc->reach == NULL || inc->uni == NULL || inc->order == NULL
+            || inc->bitsv[0] == NULL) {
+        nt_releaseInc(inc);
+        return NULL;
+    }
+
+    inc->uni[0].bits = inc->bitsv[0];
+    inc->buf.bits = inc->bitsv[0] + inc->words;
+
+    // For each level, list the subsets that include it and nothing
+    // below it, in order of population, so that the parts of a subset
+    // always come before it
+    for (size_t level = 1; level <= maxSize; level++)
+    {
+        size_t first = (size_t) 1 << (level - 1);
+        size_t *order = calloc(first, sizeof(size_t));
+        if (order == NULL) {
+            nt_releaseInc(inc);
+            return NULL;
+        }
+        inc->order[level] = order;
+
+        size_t index = 0;
+        for (int pop = 1; pop <= (int) level; pop++)
+            for (size_t m = first; m < first << 1; m++)
+                if (__builtin_popcountl(m) == pop) order[index++] = m;
+    }
+
+    return inc;
+}
+
+// Release an Incremental Testing Context
+void nt_releaseInc(NT_Inc *inc)
+{
+    if (inc->reach != NULL)
+        for (size_t m = 0; m < (size_t) 1 << inc->maxSize; m++)
+            free(inc->reach[m].v);
+    if (inc->uni != NULL)
+        for (size_t level = 0; level <= inc->maxSize; level++)
+            free(inc->uni[level].v);
+    if (inc->order != NULL)
+        for (size_t level = 0; level <= inc->maxSize; level++)
+            free(inc->order[level]);
+
+    free(inc->reach);
+    free(inc->uni);
+    free(inc->order);
+    for (size_t level = 0; level <= inc->built; level++)
+        free(inc->bitsv[level]);
+    free(inc->buf.v);
+    free(inc);
+
+    return;
+}
+
+// Test a Set, Reusing Work from the Previous Set
+// Returns 0 if nullifiable, 1 if innullifiable, -1 on memory error
+
+// Gives the same result as the usual test, but keeps what it's worked
+// out about the top values for the next call.
+int nulTestInc(NT_Inc *inc, const SetVal *set, size_t size,
+        unsigned long minm, unsigned long maxm)
+{
+    // Simple cases, ranged tests, and anything too big for the context
+    // go the usual way
+    if (size <= 2 || size > inc->maxSize)
+        return nulTest(set, size, minm, maxm);
+    if (size > 3 && (minm != 0 || maxm != 0))
+        return nulTest(set, size, minm, maxm);
+    for (size_t i = 0; i < size; i++) if (set[i] == 0) return 0;
+
+    // Keep the levels that are still the same; anything below the
+    // first top value that changed has to be redone
+    size_t shared = 0;
+    while (shared < inc->levels && shared < size - 1
+            && set[size - 1 - shared] == inc->top[shared]) shared++;
+    inc->levels = shared;
+
+    for (size_t i = shared; i < size - 1; i++)
+        inc->top[i] = set[size - 1 - i];
+
+    // Work out the rest of the levels above the lowest value, stopping
+    // if those are nullifiable on their own
+    for (size_t level = shared + 1; level < size; level++)
+    {
+        int res = addLevel(inc, level);
+        if (res != 1) return res;
+    }
+
+    // Then see if the lowest value can be made out of the others
+    return !reachable(inc, size - 1, set[0]);
+}
+
+// Work Out a Level
+// Returns 0 if nullifiable, 1 if not, -1 on memory error
+
+// Given the values above this level are innullifiable and worked out,
+// checks whether this level's value can be made out of them, and if
+// not, works out every subset that's now part of something larger, and
+// adds their values to the union. That's all of the levels above, and
+// every subset that includes this one except for all of them together.
+int addLevel(NT_Inc *inc, size_t level)
+{
+    Values *below = inc->uni + level - 1;
+    Values *uni = inc->uni + level;
+    Values *buf = &inc->buf;
+
+    if (buildLevel(inc, level)) return -1;
+
+    // If this value can be made out of the ones above, the two cancel
+    if (reachable(inc, level - 1, inc->top[level - 1])) return 0;
+
+    // Start from the union for the level above
+    clearValues(inc, uni);
+    bs_or(uni->bits, below->bits, inc->words);
+    buf->len = 0;
+
+    // Work out each new subset, collecting all their values; the last
+    // one in order is all the levels together, so skip that one, and
+    // instead do all the levels above together
+    size_t subsets = (size_t) 1 << (level - 1);
+    for (size_t i = 0; i < subsets; i++)
+    {
+        size_t m = inc->order[level][i];
+        if (i == subsets - 1) m = subsets - 1;
+        if (m == 0) continue;
+        if (reachOf(inc, m) == -1) return -1;
+
+        // Bitsets are a union, others go in the scratch list
+        Values *r = inc->reach + m;
+        bs_or(uni->bits, r->bits, inc->words);
+        for (size_t j = 0; j < r->len; j++)
+            if (pushValue(buf, r->v[j])) return -1;
+    }
+    qsort(buf->v, buf->len, sizeof(unsigned long), &cmpValue);
+
+    // Merge the list into the one from the level above
+    size_t i = 0, j = 0;
+    while (i < below->len || j < buf->len)
+    {
+        unsigned long next;
+        if (j == buf->len) next = below->v[i++];
+        else if (i == below->len) next = buf->v[j++];
+        else if (below->v[i] <= buf->v[j]) next = below->v[i++];
+        else next = buf->v[j++];
+
+        if (uni->len == 0 || uni->v[uni->len - 1] != next)
+            if (pushValue(uni, next)) return -1;
+    }
+
+    inc->levels = level;
+
+    return 1;
+}
+
+// Allocate Bitsets up to a Level
+// Returns 0 on success, -1 on memory error
+
+// The subsets new at a level are the ones with it as their highest
+// level, and they get their bitsets, along with the level's union, the
+// first time any set reaches it.
+int buildLevel(NT_Inc *inc, size_t level)
+{
+    for (; inc->built < level; inc->built++)
+    {
+        size_t at = inc->built + 1;
+        size_t first = (size_t) 1 << (at - 1);
+
+        uint64_t *bits = calloc((first + 1) * inc->words + 1,
+                sizeof(uint64_t));
+        if (bits == NULL) return -1;
+        inc->bitsv[at] = bits;
+
+        for (size_t m = first; m < first << 1; m++, bits += inc->words)
+            inc->reach[m].bits = bits;
+        inc->uni[at].bits = bits;
+    }
+
+    return 0;
+}
+
+// Work Out the Values of a Subset
+// Returns 0 on success, -1 on memory error
+
+// Finds every value the subset with the given bitmask can be made into,
+// using all of its values, from the values of its parts. Assumes the
+// parts are worked out already, and the subset is innullifiable.
+int reachOf(NT_Inc *inc, size_t m)
+{
+    Values *r = inc->reach + m;
+    clearValues(inc, r);
+
+    // A single value can only be made into itself
+    if ((m & (m - 1)) == 0) {
+        if (addValue(inc, r, inc->top[__builtin_ctzl(m)])) return -1;
+        finishValues(inc, r);
+        return 0;
+    }
+
+    // Small subsets may be in the cache; levels go down from the top
+    // value, so the values come out ascending from the highest bit
+    if (__builtin_popcountl(m) <= CACHE_SIZE) {
+        unsigned long set[CACHE_SIZE];
+        size_t size = 0;
+        for (size_t level = inc->maxSize; level-- > 0;)
+            if (m >> level & 1) set[size++] = inc->top[level];
+
+        const CacheEntry *entry = cacheGet(set, size);
+        if (entry == NULL && errno) return -1;
+        if (entry != NULL) {
+            for (size_t i = 0; i < entry->len; i++)
+                if (addValue(inc, r, entry->v[i])) return -1;
+            finishValues(inc, r);
+            return 0;
+        }
+    }
+
+    // Go through every way of splitting the subset in two, counting
+    // each split once by keeping the lowest bit on one side
+    size_t low = m & -m;
+    unsigned long limit = inc->limit;
+    for (size_t u = (m - 1) & m; u != 0; u = (u - 1) & m)
+    {
+        if (!(u & low)) continue;
+        const Values *a = inc->reach + u;
+        const Values *b = inc->reach + (m ^ u);
+        if (a->count > b->count) {
+            const Values *t = a;
+            a = b;
+            b = t;
+        }
+
+        // Every operation on a value from each part gives a value for
+        // the whole subset; go through values on the smaller side
+        size_t ai = 0;
+        for (unsigned long x; (x = nextValue(inc, a, &ai)) != 0;)
+        {
+            // Sums and differences that stay in range are shifts of
+            // the other side's bitset
+            bs_orShl(r->bits, b->bits, x, inc->words);
+            bs_orShr(r->bits, b->bits, x, inc->words);
+
+            // Everything else goes value by value
+            size_t bi = 0;
+            for (unsigned long y; (y = nextValue(inc, b, &bi)) != 0;)
+            {
+                // Sums, and differences, no zero as the parts don't
+                // collide
+                if (y > limit || x > limit - y)
+                    if (x <= ULONG_MAX - y)
+                        if (addValue(inc, r, x + y)) return -1;
+                if (y > limit || x > y)
+                    if (x != y)
+                        if (addValue(inc, r, x > y ? x - y : y - x))
+                            return -1;
+
+                // Products and quotients, if there's no
+                // overflow/remainder
+                if (x <= ULONG_MAX / y)
+                    if (addValue(inc, r, x * y)) return -1;
+                if (x % y == 0)
+                    if (addValue(inc, r, x / y)) return -1;
+                if (y % x == 0 && y != x)
+                    if (addValue(inc, r, y / x)) return -1;
+            }
+        }
+    }
+
+    finishValues(inc, r);
+
+    return 0;
+}
+
+// Check if a Value can be Made from the Top Levels
+// Returns whether it can
+
+// Looks for the value in the union for the given level, and then checks
+// whether it can be made using all of the values on those levels, by
+// going through each split of those in two and looking for a value on
+// one side that gives it with a value on the other side.
+bool reachable(const NT_Inc *inc, size_t level, unsigned long x)
+{
+    if (level == 0) return false;
+    if (hasValue(inc, inc->uni + level, x)) return true;
+    if (level == 1) return x == inc->top[0];
+
+    // Go through splits, counting each once by keeping the top value on
+    // one side
+    unsigned long limit = inc->limit;
+    size_t m = ((size_t) 1 << level) - 1;
+    for (size_t u = (m - 1) & m; u != 0; u = (u - 1) & m)
+    {
+        if (!(u & 1)) continue;
+        const Values *a = inc->reach + u;
+        const Values *b = inc->reach + (m ^ u);
+        if (a->count > b->count) {
+            const Values *t = a;
+            a = b;
+            b = t;
+        }
+
+        // Differences in range are intersections of shifted bitsets
+        if (bs_intersectsShl(a->bits, b->bits, x, inc->words))
+            return true;
+        if (bs_intersectsShl(b->bits, a->bits, x, inc->words))
+            return true;
+
+        // For each value on the smaller side, look for the values on
+        // the other side that would give this one
+        size_t ai = 0;
+        for (unsigned long y; (y = nextValue(inc, a, &ai)) != 0;)
+        {
+            // Sum, and differences out of range
+            if (x > y) if (hasValue(inc, b, x - y)) return true;
+            if (y > limit || x > limit - y)
+                if (x <= ULONG_MAX - y)
+                    if (hasValue(inc, b, x + y)) return true;
+            if (y > limit && y > x)
+                if (hasValue(inc, b, y - x)) return true;
+
+            // Products and quotients
+            if (x % y == 0) if (hasValue(inc, b, x / y)) return true;
+            if (y % x == 0) if (hasValue(inc, b, y / x)) return true;
+            if (x <= ULONG_MAX / y)
+                if (hasValue(inc, b, x * y)) return true;
+        }
+    }
+
+    return false;
+}
+
+// Empty a Set of Values
+void clearValues(const NT_Inc *inc, Values *set)
+{
+    bs_clear(set->bits, inc->words);
+    set->len = 0;
+    set->count = 0;
+
+    return;
+}
+
+// Add a Value to a Set
+// Returns 0 on success, -1 on memory error
+
+// Values above the limit are only listed; call the finishing function
+// before using the set.
+int addValue(const NT_Inc *inc, Values *set, unsigned long value)
+{
+    if (value <= inc->limit) {
+        bs_set(set->bits, value);
+        return 0;
+    }
+
+    return pushValue(set, value);
+}
+
+// Finish Adding to a Set
+
+// Sorts the list of values above the limit, removes duplicates, and
+// counts up the values. Zero never counts as a value.
+void finishValues(const NT_Inc *inc, Values *set)
+{
+    if (inc->words > 0) set->bits[0] &= ~(uint64_t) 1;
+
+    qsort(set->v, set->len, sizeof(unsigned long), &cmpValue);
+    size_t uniq = 0;
+    for (size_t i = 0; i < set->len; i++)
+        if (uniq == 0 || set->v[i] != set->v[uniq - 1])
+            set->v[uniq++] = set->v[i];
+    set->len = uniq;
+
+    set->count = uniq;
+    for (size_t i = 0; i < inc->words; i++)
+        set->count += __builtin_popcountll(set->bits[i]);
+
+    return;
+}
+
+// Check if a Set Contains a Value
+bool hasValue(const NT_Inc *inc, const Values *set, unsigned long value)
+{
+    if (value <= inc->limit) return bs_test(set->bits, value);
+
+    // Binary search
+    size_t lo = 0, hi = set->len;
+    while (lo < hi)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        if (set->v[mid] == value) return true;
+        else if (set->v[mid] < value) lo = mid + 1;
+        else hi = mid;
+    }
+
+    return false;
+}
+
+// Get the Next Value in a Set
+// Returns the value, or zero at the end
+
+// Goes through the values in a set in ascending order, with the given
+// position starting at zero.
+unsigned long nextValue(const NT_Inc *inc, const Values *set,
+        size_t *pos)
+{
+    // Bitset first
+    size_t bits = inc->words * 64;
+    if (*pos < bits) {
+        *pos = bs_next(set->bits, inc->words, *pos);
+        if (*pos < bits) return (*pos)++;
+    }
+
+    // Then the list
+    size_t i = *pos - bits;
+    if (i >= set->len) return 0;
+    (*pos)++;
+
+    return set->v[i];
+}
+
+// Add a Value to the End of a List
+// Returns 0 on success, -1 on memory error
+int pushValue(Values *list, unsigned long value)
+{
+    if (list->len == list->cap) {
+        size_t cap = list->cap ? list->cap * 2 : 0x10;
+        unsigned long *v = realloc(list->v, cap * sizeof(unsigned long));
+        if (v == NULL) return -1;
+        list->v = v;
+        list->cap = cap;
+    }
+
+    list->v[list->len++] = value;
+
+    return 0;
+}
+
+// Compare Values for Sorting
+int cmpValue(const void *a, const void *b)
+{
+    unsigned long x = *(const unsigned long *) a;
+    unsigned long y = *(const unsigned long *) b;
+
+    return (x > y) - (x < y);
+}
@@ -7,7 +7,35 @@
 
 #include <stdlib.h>
 
-int nulTest(const unsigned long *, size_t,
+#include "setVal.h"
+
+int nulTest(const SetVal *, size_t,
+        unsigned long, unsigned long);
+
+// Oracle for Reduced Sets, and what it Returns when it doesn't Know
+typedef int NT_Oracle(const unsigned long *, size_t);
+#define NT_UNKNOWN 2
+
+// Set an Oracle for Reduced Sets of One Size
+void nt_setOracle(size_t, NT_Oracle *);
+
+// Set up the Cache of Reachable Values
+int nt_initCache(unsigned long, size_t);
+
+// Release the Cache of Reachable Values
+void nt_releaseCache(void);
+
+// Incremental Testing Context
+typedef struct NulInc NT_Inc;
+
+// Initialize an Incremental Testing Context
+NT_Inc *nt_initInc(size_t, unsigned long);
+
+// Release an Incremental Testing Context
+void nt_releaseInc(NT_Inc *);
+
+// Test a Set, Reusing Work from the Previous Set
+int nulTestInc(NT_Inc *, const SetVal *, size_t,
         unsigned long, unsigned long);
 
 #endif
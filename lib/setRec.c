@@ -73,21 +73,82 @@
 // the number of concurrent calls) each iteration, which I found to be
 // faster than splitting the query space up into N segments.
 
+// The library also keeps count of how many sets have each bit marked,
+// so that's known right away without scanning the record. Each thread
+// counts the bits it newly marks in its own shard of counters, on its
+// own cache line, and the shards are added up when asked. The counts
+// are kept in the header when exporting, and worked out again when
+// importing a record without them.
+
+// It also keeps track of which blocks of the array have had anything
+// newly marked since the record was last imported or exported, with a
+// bit for each block. That way, a record can be written back over the
+// file it came from by writing only those blocks, which is much quicker
+// when only a little has changed. Marking only checks the bit, and only
+// sets it if it isn't already, so it's nearly free once a block's been
+// touched. The counts of marked sets are left out of the header when
+// writing this way, as they're likely to be out of date by the end.
+// Clearing bits is noted as well, since then a file cut short partway
+// through writing isn't a valid state unless its header is the old one.
+
+#define _DEFAULT_SOURCE
+
 #include <stdatomic.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 
 #include <errno.h>
+#include <string.h>
+#include <unistd.h>
 
 #include "setRec.h"
 
 #define FIXED_MAX 4
 #define PERIOD 0x1000
 
+// Bits per Set, and Shards of Counters
+#define BITS 8
+#define SHARDS 64
+
+// Sets per Block, and Blocks per Word of Dirty Bits
+#define BLOCK 0x1000
+#define WORD 64
+
+// Blocks Read at a Time when Merging
+#define MERGE 0x40
+
 // Individual Set Record Type
 typedef _Atomic char Rec;
 
+// Vector of Bit-Fields, for Merging
+typedef unsigned char Vec __attribute__((vector_size(32)));
+
+// Index among All Sets of a Size, which can be Huge with Fixed Values
+typedef unsigned __int128 Place;
+
+// Word of Dirty Bits, One per Block
+typedef atomic_uint_least64_t Dirty;
+
+// Counts of Sets with each Bit Marked, One Shard
+typedef struct Counts Counts;
+struct Counts {
+    _Alignas(64) atomic_size_t bits[BITS];
+};
+
+// Output Function
+typedef void OutFun(const SetVal *, size_t, char);
+
+// Functions Specialised for One Variable Size
+typedef struct Kernels {
+    size_t (*toIndex)(const SetVal *, size_t);
+    ssize_t (*query)(const Rec *, unsigned long, size_t,
+            const unsigned long *, size_t,
+            size_t, size_t, size_t, char, char,
+            atomic_size_t *, size_t, OutFun *);
+} Kernels;
+
 // Set Record Information Structure
 typedef struct Base Base;
 struct Base {
@@ -98,10 +159,33 @@ struct Base {
     unsigned long mval_max;
     size_t fixedSize;       // number of fixed values
     unsigned long fixedv[FIXED_MAX];
+    bool tested;            // whether a tested range is recorded
+    unsigned long test_min;
+    unsigned long test_max;
+    unsigned long prev_max; // max M-value before extending, 0 if not
+    Counts *counts;         // marked sets per bit, in shards
+    Dirty *dirty;           // blocks changed since last written
+    atomic_bool *cleared;   // bits taken off since last written
+    size_t first;           // index of the first set among all sets
+    const Kernels *kern;    // for the variable size
 };
 
-// Output Function
-typedef void OutFun(const unsigned long *, size_t, char);
+// Contents of a File's Header
+typedef struct Header {
+    size_t size;
+    size_t varSize;
+    unsigned long minm;
+    unsigned long maxm;
+    size_t fixedSize;
+    unsigned long fixed[FIXED_MAX];
+    bool tested;
+    unsigned long testMin;
+    unsigned long testMax;
+    bool extended;
+    unsigned long prevMax;
+    bool counted;
+    size_t c[BITS];
+} Header;
 
 // Header Format Strings
 const char *hdrFmtFull =
@@ -112,6 +196,13 @@ const char *hdrFmtVar =
 const char *hdrFmtFixed =
         "Fixed Segment -- Size: %lu, "
         "Values: %lu, %lu, %lu, %lu\n";     // matches FIXED_MAX
+const char *hdrFmtTested =
+        "Tested -- Reduction M-Value Range: %lu to %lu\n";
+const char *hdrFmtExtended =
+        "Extended -- Previous Max M-Value: %lu\n";
+const char *hdrFmtMarked =
+        "Marked -- Sets per Bit: "
+        "%zu %zu %zu %zu %zu %zu %zu %zu\n";       // matches BITS
 const char *hdrMsgData =
         "Data begins 4K (4096) into the file\n";
 
@@ -121,19 +212,98 @@ const char *hdrMsgData =
 #define TOTAL_B(base) \
             TOTAL(base->mval_min, base->mval_max, base->varSize)
 
+// Macros for Calculating Size of Dirty Bits
+#define BLOCKS(total) (((total) + BLOCK - 1) / BLOCK)
+#define WORDS(total) ((BLOCKS(total) + WORD - 1) / WORD)
+
+// Largest Variable Size with its own Kernels
+#define KERN_MAX 12
+
+// Helpers the Kernels are Made from, Always Inlined
+#define KERNEL static inline __attribute__((always_inline))
+
 // Helper Function Declarations
-static int mark(Rec *, unsigned long,
-        const unsigned long *, size_t, char);
-static ssize_t query(const Rec *,
-        unsigned long, unsigned long, size_t,
+KERNEL ssize_t findSet(const Base *, const SetVal *, size_t);
+static int mark(Rec *, Counts *, Dirty *, size_t, char, char);
+static size_t markSupers(const Base *, const SetVal *, size_t, size_t,
+        unsigned long, unsigned long, size_t, char, char);
+KERNEL ssize_t query(const Rec *,
+        unsigned long, size_t,
         const unsigned long *, size_t,
-        size_t, size_t, char, char,
-        size_t *, size_t, OutFun *);
+        size_t, size_t, size_t, char, char,
+        atomic_size_t *, size_t, OutFun *);
+
+KERNEL void incSetValues(SetVal *, size_t, size_t);
+KERNEL void indexToSet(SetVal *, size_t, size_t);
+KERNEL size_t setToIndex(const SetVal *, size_t);
+KERNEL unsigned long long mcn(size_t, size_t);
+
+static Counts *myShard(Counts *);
+static void countBits(const Rec *, size_t, Counts *);
+static void sumBits(const Counts *, size_t [BITS]);
+
+static void setDirty(Dirty *, size_t);
+static void fillDirty(Dirty *, size_t, uint64_t);
+static int readHeader(FILE *restrict, Header *);
+static int writeHeader(const Base *, FILE *restrict, const size_t *);
+static int orFile(Base *, FILE *restrict, size_t, size_t);
+static size_t orBlock(Rec *, const unsigned char *, size_t,
+        size_t [BITS]);
+static Place place(size_t, unsigned long, size_t, const unsigned long *);
+static bool extendedFrom(const Base *, const Header *, long);
+static bool sameRecord(const Base *, const Header *);
+
+// ============ Kernels
+
+// The functions that go over a set's values are made again for each
+// variable size up to a point, with the size fixed, so the compiler can
+// unroll the loops and work out the choices at compile time. Records
+// pick theirs when allocated, and any larger size uses the general
+// ones.
+
+#define KERNELS(N) \
+    static size_t setToIndex##N(const SetVal *set, \
+            size_t varSize) \
+    { \
+        (void) varSize; \
+        return setToIndex(set, N); \
+    } \
+    static ssize_t query##N(const Rec *rec, unsigned long minm, \
+            size_t varSize, const unsigned long *fixedv, \
+            size_t fixedSize, size_t start, size_t end, size_t skip, \
+            char mask, char bits, atomic_size_t *progress, \
+            size_t period, OutFun *out) \
+    { \
+        (void) varSize; \
+        return query(rec, minm, N, fixedv, fixedSize, start, end, \
+                skip, mask, bits, progress, period, out); \
+    }
+
+KERNELS(1) KERNELS(2) KERNELS(3) KERNELS(4) KERNELS(5) KERNELS(6)
+KERNELS(7) KERNELS(8) KERNELS(9) KERNELS(10) KERNELS(11) KERNELS(12)
+
+// General Kernels, for Any Size
+static size_t setToIndexAny(const SetVal *set, size_t varSize)
+{
+    return setToIndex(set, varSize);
+}
+
+static ssize_t queryAny(const Rec *rec, unsigned long minm,
+        size_t varSize, const unsigned long *fixedv, size_t fixedSize,
+        size_t start, size_t end, size_t skip, char mask, char bits,
+        atomic_size_t *progress, size_t period, OutFun *out)
+{
+    return query(rec, minm, varSize, fixedv, fixedSize, start, end,
+            skip, mask, bits, progress, period, out);
+}
 
-static void incSetValues(unsigned long *, size_t, size_t);
-static void indexToSet(unsigned long *, size_t, size_t);
-static size_t setToIndex(const unsigned long *, size_t);
-static unsigned long long mcn(size_t, size_t);
+// Kernels by Variable Size
+#define KERN(N) {&setToIndex##N, &query##N}
+static const Kernels kernels[KERN_MAX + 1] = {
+    {&setToIndexAny, &queryAny},
+    KERN(1), KERN(2), KERN(3), KERN(4), KERN(5), KERN(6),
+    KERN(7), KERN(8), KERN(9), KERN(10), KERN(11), KERN(12)
+};
 
 // ============ User-Level Functions
 
@@ -154,13 +324,32 @@ Base *sr_initialize(size_t size)
     Base *base = malloc(sizeof(Base));
     if (base == NULL) return NULL;
 
+    // And the Counters
+    base->counts = aligned_alloc(64, SHARDS * sizeof(Counts));
+    base->cleared = malloc(sizeof(atomic_bool));
+    if (base->counts == NULL || base->cleared == NULL) {
+        free(base->counts);
+        free(base->cleared);
+        free(base);
+        return NULL;
+    }
+    atomic_init(base->cleared, false);
+    for (size_t i = 0; i < SHARDS; i++)
+        for (size_t b = 0; b < BITS; b++)
+            atomic_init(&base->counts[i].bits[b], 0);
+
     // Populate to indicate empty
     base->rec = NULL;
+    base->dirty = NULL;
     base->size = size;
     base->varSize = size;
     base->mval_min = 1; // avoid uflow when decrementing for total calc
     base->mval_max = 0;
     base->fixedSize = 0;
+    base->tested = false;
+    base->prev_max = 0;
+    base->first = 0;
+    base->kern = kernels;
 
     return base;
 }
@@ -186,6 +375,10 @@ int sr_alloc(Base *base,
     if (fixedSize > 0) if (fixedv[0] <= maxm) return -1;
     for (size_t i = 1; i < fixedSize; i++)
         if (fixedv[i] <= fixedv[i - 1]) return -1;
+
+    // And that every value fits in a set
+    if (maxm > SET_VAL_MAX) return -1;
+    if (fixedSize > 0) if (fixedv[fixedSize - 1] > SET_VAL_MAX) return -1;
     errno = 0;
 
     // Populate Information Structure
@@ -193,16 +386,83 @@ int sr_alloc(Base *base,
     base->mval_min = minm;
     base->mval_max = maxm;
     base->fixedSize = fixedSize;
-    for (size_t i = 0; i < fixedSize; i++)
-        base->fixedv[i] = fixedv[i];
+    for (size_t i = 0; i < FIXED_MAX; i++)
+        base->fixedv[i] = i < fixedSize ? fixedv[i] : 0;
+    base->tested = false;
+    base->prev_max = 0;
+    base->first = mcn(minm - 1, varSize);
+    base->kern = kernels + (varSize <= KERN_MAX ? varSize : 0);
 
     // Allocate Memory for Record Array
-    Rec *rec = calloc(TOTAL_B(base), sizeof(Rec));
+    size_t total = TOTAL_B(base);
+    Rec *rec = calloc(total, sizeof(Rec));
     if (rec == NULL) return -1;
 
-    // Deallocate existing array and replace it
+    // And the Dirty Bits
+    Dirty *dirty = calloc(WORDS(total), sizeof(Dirty));
+    if (dirty == NULL) {
+        free(rec);
+        return -1;
+    }
+
+    // Deallocate existing arrays and replace them
     free(base->rec);
+    free(base->dirty);
+    base->rec = rec;
+    base->dirty = dirty;
+
+    // None of it's been written anywhere
+    fillDirty(dirty, total, UINT64_MAX);
+
+    // Nothing's marked
+    for (size_t i = 0; i < SHARDS; i++)
+        for (size_t b = 0; b < BITS; b++)
+            atomic_store(&base->counts[i].bits[b], 0);
+
+    return 0;
+}
+
+// Extend a Set Record's M-Range
+// Returns 0 on success, -1 on error (read errno)
+
+// Raises the maximum M-value of an allocated record, keeping every mark
+// it already has. Sorted the combinadic way, sets with higher M-values
+// all come after the ones already there, so the array only grows at
+// the end, and the new sets start out unmarked and noted as changed.
+// The record keeps a note of the maximum M-value it had before, so work
+// can be done on just the new sets; extending again keeps the first
+// note until it's cleared. On error, record is preserved.
+int sr_extend(Base *base, unsigned long maxm)
+{
+    // Validate New Maximum
+    errno = EINVAL;
+    if (maxm < base->mval_max) return -1;
+    if (base->fixedSize > 0) if (base->fixedv[0] <= maxm) return -1;
+    if (maxm > SET_VAL_MAX) return -1;
+    errno = 0;
+
+    if (maxm == base->mval_max) return 0;
+
+    // Grow the Array, the New Sets Unmarked
+    size_t before = TOTAL_B(base);
+    size_t total = TOTAL(base->mval_min, maxm, base->varSize);
+    Rec *rec = realloc(base->rec, total * sizeof(Rec));
+    if (rec == NULL) return -1;
     base->rec = rec;
+    memset((void *) (rec + before), 0, (total - before) * sizeof(Rec));
+
+    // And the Dirty Bits, with the New Blocks Set
+    Dirty *dirty = realloc(base->dirty, WORDS(total) * sizeof(Dirty));
+    if (dirty == NULL) return -1;
+    base->dirty = dirty;
+    for (size_t w = WORDS(before); w < WORDS(total); w++)
+        atomic_init(dirty + w, 0);
+    for (size_t b = before / BLOCK; b < BLOCKS(total); b++)
+        setDirty(dirty, b * BLOCK);
+
+    // Note where it was Extended from
+    if (base->prev_max == 0) base->prev_max = base->mval_max;
+    base->mval_max = maxm;
 
     return 0;
 }
@@ -213,8 +473,11 @@ int sr_alloc(Base *base,
 // destroyed.
 void sr_release(Base *base)
 {
-    // Free the array, then the information structure
+    // Free the arrays and counters, then the information structure
     free(base->rec);
+    free(base->dirty);
+    free(base->counts);
+    free(base->cleared);
     free(base);
 
     return;
@@ -263,6 +526,96 @@ size_t sr_getTotal(const Base *base)
     return TOTAL_B(base);
 }
 
+// Get Property: Tested Reduction Range
+// Returns 1 if a range is recorded, 0 otherwise
+
+// The tested range is a note kept in the record's header, saying which
+// initial reduction range any sets with the 'tested' bit have been
+// exhaustively tested under. The library doesn't interpret it.
+int sr_getTested(const Base *base, unsigned long *minm,
+        unsigned long *maxm)
+{
+    if (!base->tested) return 0;
+    if (minm != NULL) *minm = base->test_min;
+    if (maxm != NULL) *maxm = base->test_max;
+
+    return 1;
+}
+
+// Get Property: Where a Record was Extended from
+// Returns 1 if the record has been extended, 0 otherwise
+
+// Gives the maximum M-value the record had before it was first extended,
+// and the index of the first set added since, as the sets from there to
+// the end are the ones that are new.
+int sr_getExtended(const Base *base, unsigned long *maxm, size_t *start)
+{
+    if (!base->prev_max) return 0;
+    if (maxm != NULL) *maxm = base->prev_max;
+    if (start != NULL)
+        *start = TOTAL(base->mval_min, base->prev_max, base->varSize);
+
+    return 1;
+}
+
+// Get Property: Number of Sets with a Bit Marked
+
+// Takes a bitmask with a single bit, like the ones used for marking.
+// This is exact as long as nothing is marking sets at the same time.
+size_t sr_getMarked(const Base *base, char bit)
+{
+    size_t sums[BITS];
+    sumBits(base->counts, sums);
+
+    return sums[__builtin_ctz((unsigned char) bit)];
+}
+
+// Get Property: Index of a Set
+
+// Where the set sits in the record, counting from the first set. Only
+// the variable values are looked at, and the set must be in the
+// record's range, as there's no checking.
+size_t sr_getIndex(const Base *base, const SetVal *set)
+{
+    return base->kern->toIndex(set, base->varSize) - base->first;
+}
+
+// Get Property: Bits Marked on a Set
+// Returns the bits, 0 if the set isn't in the record, -1 on error (read
+// errno)
+
+// Looks up a single set, which can be anything of the record's size;
+// sets out of its range or without its fixed values have no bits.
+int sr_getBits(const Base *base, const SetVal *set, size_t size)
+{
+    ssize_t index = findSet(base, set, size);
+    if (index < 0) return index == -1 ? -1 : 0;
+
+    return (unsigned char) atomic_load_explicit(base->rec + index,
+            memory_order_relaxed);
+}
+
+// Set Property: Tested Reduction Range
+void sr_setTested(Base *base, unsigned long minm, unsigned long maxm)
+{
+    base->tested = true;
+    base->test_min = minm;
+    base->test_max = maxm;
+
+    return;
+}
+
+// Clear Property: Where a Record was Extended from
+
+// For once the work on the new sets is done, so they aren't treated as
+// new again, and the next extension is noted afresh.
+void sr_clearExtended(Base *base)
+{
+    base->prev_max = 0;
+
+    return;
+}
+
 // Mark a Certain Set
 // Returns 1 if newly marked, 0 if already marked or unallocated, -1 on
 // error (read errno)
@@ -270,33 +623,175 @@ size_t sr_getTotal(const Base *base)
 // ORs on the given bits on the specified set in the record, thus
 // 'Marking' that set. The input must be a valid set, in increasing
 // order, within the record's allocated M-Value Range.
-int sr_mark(const Base *base, const unsigned long *set, size_t size,
+int sr_mark(const Base *base, const SetVal *set, size_t size,
         char mask)
+{
+    return sr_markFresh(base, set, size, mask, 0);
+}
+
+// Mark a Certain Set, Noting it if New
+// Returns 1 if newly marked, 0 if already marked or unallocated, -1 on
+// error (read errno)
+
+// Same as above, but if the set had none of the given bits before, the
+// fresh bits are ORed on too, so sets that are newly marked can be
+// picked out later, and taken off once they've been dealt with.
+int sr_markFresh(const Base *base, const SetVal *set, size_t size,
+        char mask, char fresh)
+{
+    // Find the set, skipping it if it's not in the record
+    ssize_t index = findSet(base, set, size);
+    if (index < 0) return index == -1 ? -1 : 0;
+
+    // Mark this set on the record
+    int res = mark(base->rec, base->counts, base->dirty, index, mask,
+            fresh);
+
+    return res;
+}
+
+// Mark a Certain Set Only this Thread Marks
+// Returns 1 if newly marked, 0 if already marked or unallocated, -1 on
+// error (read errno)
+
+// Same as above, but for a set that nothing else marks while this is
+// being done, like one in a stretch of the record that a single thread
+// is working through. The bits are put in with a plain store rather
+// than an atomic OR, so there's no locked instruction per set.
+int sr_markOwn(const Base *base, const SetVal *set, size_t size,
+        char mask, char fresh)
+{
+    ssize_t index = findSet(base, set, size);
+    if (index < 0) return index == -1 ? -1 : 0;
+
+    // OR the bits on, noting the set if it's new
+    Rec *at = base->rec + index;
+    char prev = atomic_load_explicit(at, memory_order_relaxed);
+    char bits = prev | mask;
+    if (fresh && !(prev & mask)) bits |= fresh;
+    if (bits == prev) return 0;
+    atomic_store_explicit(at, bits, memory_order_relaxed);
+
+    // Count the ones we set
+    Counts *shard = myShard(base->counts);
+    for (unsigned char added = bits & ~prev; added;
+            added &= added - 1) {
+        atomic_size_t *c = shard->bits + __builtin_ctz(added);
+        atomic_fetch_add_explicit(c, 1, memory_order_relaxed);
+    }
+    setDirty(base->dirty, index);
+
+    return (prev & mask) != mask;
+}
+
+// Mark Every Superset of a Set
+// Returns number of sets newly marked, -1 on error (read errno)
+
+// Marks every set in the record that has all the given values, which
+// can be any smaller number of them, the same as marking each in turn.
+// The sets are gone through in order, filling in values from the
+// M-value down and keeping the part of the index those add, so no set's
+// index is worked out from scratch, and the lowest values make a run
+// of neighbouring sets. Given values above the M-range have to be fixed
+// values of the record, or there's nothing to mark.
+ssize_t sr_markSupersets(const Base *base, const SetVal *set,
+        size_t size, char mask, char fresh)
 {
 #ifndef NO_VALIDATE
     // Validate input set: values must be positive and ascending, and
-    // size must be N
+    // no more than N of them
     errno = EINVAL;
-    if (size != base->size) return -1;
-    if (set[0] < 1) return -1;
+    if (size > base->size) return -1;
+    if (size > 0 && set[0] < 1) return -1;
     for (size_t i = 1; i < size; i++)
         if (set[i] <= set[i - 1]) return -1;
     errno = 0;
 #endif
 
-    // Skip if set M-value is out of range
-    size_t varSize = base->varSize;
-    if (set[varSize - 1] > base->mval_max
-            || set[varSize - 1] < base->mval_min) return 0;
+    // Split the given values into variable and fixed ones
+    size_t varc = 0;
+    while (varc < size && set[varc] <= base->mval_max) varc++;
+    if (varc > base->varSize) return 0;
 
-    // Skip if fixed values don't match
-    for (size_t i = 0; i < base->fixedSize; i++)
-        if (set[varSize + i] != base->fixedv[i]) return 0;
+    for (size_t i = varc; i < size; i++) {
+        size_t f = 0;
+        while (f < base->fixedSize && base->fixedv[f] != set[i]) f++;
+        if (f == base->fixedSize) return 0;
+    }
 
-    // Mark this set on the record
-    int res = mark(base->rec, base->mval_min, set, varSize, mask);
+    return markSupers(base, set, varc, base->varSize, base->mval_min,
+            base->mval_max + 1, 0, mask, fresh);
+}
 
-    return res;
+// Clear Bits on Every Set
+
+// ANDs off the given bits on every set in the record, so no sets have
+// them marked anymore. This isn't meant to be done concurrently with
+// marking.
+void sr_clear(const Base *base, char mask)
+{
+    size_t total = TOTAL_B(base);
+    for (size_t i = 0; i < total; i++)
+        atomic_fetch_and(base->rec + i, ~mask);
+
+    for (size_t b = 0; b < BITS; b++)
+        if (mask & 1 << b)
+            for (size_t i = 0; i < SHARDS; i++)
+                atomic_store(&base->counts[i].bits[b], 0);
+
+    fillDirty(base->dirty, total, UINT64_MAX);
+    atomic_store(base->cleared, true);
+
+    return;
+}
+
+// Mark Bits on Every Set
+
+// ORs the given bits on every set in the record, the opposite of
+// clearing them, for when most sets are to be marked and only a few
+// taken off again. This isn't meant to be done concurrently with
+// marking.
+void sr_fill(const Base *base, char mask)
+{
+    size_t total = TOTAL_B(base);
+    for (size_t i = 0; i < total; i++)
+        atomic_fetch_or(base->rec + i, mask);
+
+    for (size_t b = 0; b < BITS; b++)
+        if (mask & 1 << b)
+            for (size_t i = 0; i < SHARDS; i++)
+                atomic_store(&base->counts[i].bits[b], i ? 0 : total);
+
+    fillDirty(base->dirty, total, UINT64_MAX);
+
+    return;
+}
+
+// Clear Bits on a Slice of Sets
+
+// Same as above, but only on the sets from the start index up to (not
+// including) the end index, like a query slice, so a process working on
+// one shard of a record can take off the bits for only its own sets.
+// Only the blocks that had bits taken off are written on an update.
+void sr_clear_slice(const Base *base, char mask, size_t start,
+        size_t end)
+{
+    Counts *shard = myShard(base->counts);
+    for (size_t i = start; i < end; i++) {
+        unsigned char removed = mask & atomic_fetch_and(base->rec + i,
+                ~mask);
+        if (!removed) continue;
+
+        // Counts are summed over shards, so one can go below zero
+        for (; removed; removed &= removed - 1) {
+            atomic_size_t *c = shard->bits + __builtin_ctz(removed);
+            atomic_fetch_sub_explicit(c, 1, memory_order_relaxed);
+        }
+        setDirty(base->dirty, i);
+        atomic_store_explicit(base->cleared, true, memory_order_relaxed);
+    }
+
+    return;
 }
 
 // Output Sets with Particular Mark Status
@@ -306,13 +801,12 @@ int sr_mark(const Base *base, const unsigned long *set, size_t size,
 // according to the given bit settings. Progress reference and output
 // function can be set to NULL if not desired.
 ssize_t sr_query(const Base *base, char mask, char bits,
-        size_t *prog, OutFun *out)
+        atomic_size_t *prog, OutFun *out)
 {
     // Output Sets that Match Query
-    ssize_t res = query(base->rec,
-            base->mval_min, base->mval_max, base->varSize,
-            base->fixedv, base->fixedSize,
-            0, 1, mask, bits, prog, PERIOD, out);
+    ssize_t res = base->kern->query(base->rec, base->mval_min,
+            base->varSize, base->fixedv, base->fixedSize,
+            0, TOTAL_B(base), 1, mask, bits, prog, PERIOD, out);
 
     return res;
 }
@@ -325,7 +819,7 @@ ssize_t sr_query(const Base *base, char mask, char bits,
 // for that parameter, giving full coverage.
 ssize_t sr_query_parallel(const Base *base, char mask, char bits,
         size_t concurrents, size_t mod,
-        size_t *prog, OutFun *out)
+        atomic_size_t *prog, OutFun *out)
 {
 #ifndef NO_VALIDATE
     // Validate Parallelism
@@ -335,10 +829,66 @@ ssize_t sr_query_parallel(const Base *base, char mask, char bits,
 #endif
 
     // Output Sets that Match Query
-    ssize_t res = query(base->rec,
-            base->mval_min, base->mval_max, base->varSize,
-            base->fixedv, base->fixedSize,
-            mod, concurrents, mask, bits, prog, PERIOD, out);
+    ssize_t res = base->kern->query(base->rec, base->mval_min,
+            base->varSize, base->fixedv, base->fixedSize,
+            mod, TOTAL_B(base), concurrents, mask, bits,
+            prog, PERIOD, out);
+
+    return res;
+}
+
+// Output Sets with Particular Mark Status, for Parallelism, over a Slice
+// Returns number of sets on success, -1 on error (read errno)
+
+// Same as the parallel query, but only over the sets from the start
+// index up to (not including) the end index, to pick up where an
+// earlier scan left off, or to split a record between processes.
+// Progress counts from the start index.
+ssize_t sr_query_slice(const Base *base, char mask, char bits,
+        size_t start, size_t end, size_t concurrents, size_t mod,
+        atomic_size_t *prog, OutFun *out)
+{
+#ifndef NO_VALIDATE
+    // Validate Parallelism
+    errno = EINVAL;
+    if (mod >= concurrents) return -1;
+    errno = 0;
+#endif
+
+    // Clamp Slice to Record
+    size_t total = TOTAL_B(base);
+    if (end > total) end = total;
+    if (start > end) start = end;
+
+    // Output Sets that Match Query
+    ssize_t res = base->kern->query(base->rec, base->mval_min,
+            base->varSize, base->fixedv, base->fixedSize,
+            start + mod, end, concurrents, mask, bits,
+            prog, PERIOD, out);
+
+    return res;
+}
+
+// Output Sets with Particular Mark Status, over a Range
+// Returns number of sets on success, -1 on error (read errno)
+
+// Same as above, but only scans the contiguous range of sets from the
+// start index up to (not including) the end index. Since neighbouring
+// sets share most of their values, this suits callers that want to
+// reuse work between consecutive sets.
+ssize_t sr_query_range(const Base *base, char mask, char bits,
+        size_t start, size_t end,
+        atomic_size_t *prog, OutFun *out)
+{
+    // Clamp Range to Record
+    size_t total = TOTAL_B(base);
+    if (end > total) end = total;
+    if (start > end) start = end;
+
+    // Output Sets that Match Query
+    ssize_t res = base->kern->query(base->rec, base->mval_min,
+            base->varSize, base->fixedv, base->fixedSize,
+            start, end, 1, mask, bits, prog, PERIOD, out);
 
     return res;
 }
@@ -353,40 +903,23 @@ int sr_import(Base *base, FILE *restrict f)
 {
     int res;
 
-    // Header follows the Reserved Space
-    res = fseek(f, 0x0800, SEEK_SET);
-    if (res < 0) return -1;
-
-    // Read Numbers for Full Set
-    size_t size;
-    res = fscanf(f, hdrFmtFull, &size);
-    if (res == EOF && ferror(f)) return -1;
-    else if (res != 1) return -3;
+    // Read the Header
+    Header h;
+    res = readHeader(f, &h);
+    if (res) return res;
 
     // Exit if record is wrong size
-    if (size != base->size) return -2;
-
-    // Read Numbers for Variable Segment
-    size_t varSize;
-    unsigned long minm, maxm;
-    res = fscanf(f, hdrFmtVar, &varSize, &minm, &maxm);
-    if (res == EOF && ferror(f)) return -1;
-    else if (res != 3) return -3;
-
-    // Read Numbers for Fixed Segment
-    size_t fixedSize;
-    unsigned long fixed[4];
-    res = fscanf(f, hdrFmtFixed, &fixedSize,
-            fixed, fixed + 1, fixed + 2, fixed + 3);
-    if (res == EOF && ferror(f)) return -1;
-    else if (res != 5) return -3;
+    if (h.size != base->size) return -2;
 
     // Allocate New Array
-    res = sr_alloc(base, varSize, minm, maxm, fixedSize, fixed);
+    res = sr_alloc(base, h.varSize, h.minm, h.maxm,
+            h.fixedSize, h.fixed);
     if (res == -1) {
         if (errno == EINVAL) return -3;
         else return -1;
     }
+    if (h.tested) sr_setTested(base, h.testMin, h.testMax);
+    if (h.extended) base->prev_max = h.prevMax;
 
     // Raw array is one block into the file
     res = fseek(f, 0x1000, SEEK_SET);
@@ -400,48 +933,256 @@ int sr_import(Base *base, FILE *restrict f)
         else return -3;
     }
 
+    // Take the counts, or work them out
+    if (h.counted)
+        for (size_t b = 0; b < BITS; b++)
+            atomic_store(&base->counts[0].bits[b], h.c[b]);
+    else countBits(base->rec, total, base->counts);
+
+    // Matches the file now
+    fillDirty(base->dirty, total, 0);
+    atomic_store(base->cleared, false);
+
     return 0;
 }
 
-// Export Record to Binary File
-// Returns 0 on success, -1 on error (read errno)
-
-// Writes a record's state to a data file, to be Imported later.
-int sr_export(const Base *base, FILE *restrict f)
+// Merge a Record from a Binary File
+// Returns 0 on success, -1 on error (read errno), -2 on different
+// record, -3 on invalid file
+
+// ORs every set's bits from the file into the record, as if everything
+// marked there had been marked here too. The file must hold a record
+// with the same set size, M-range, and fixed values, and if both have a
+// tested range, it must be the same. The array's read a stretch at a
+// time, and compared a vector at a time, so only the blocks that gain
+// anything are written to, counted, and noted as changed.
+int sr_merge(Base *base, FILE *restrict f)
 {
     int res;
 
-    // Header follows the Reserved Space
-    res = fseek(f, 0x0800, SEEK_SET);
-    if (res < 0) return -1;
+    // Read the Header
+    Header h;
+    res = readHeader(f, &h);
+    if (res) return res;
+
+    // Has to be the same shape of record
+    if (h.size != base->size || h.varSize != base->varSize
+            || h.minm != base->mval_min || h.maxm != base->mval_max
+            || h.fixedSize != base->fixedSize) return -2;
+    for (size_t i = 0; i < h.fixedSize; i++)
+        if (h.fixed[i] != base->fixedv[i]) return -2;
+    if (h.tested && base->tested && (h.testMin != base->test_min
+            || h.testMax != base->test_max)) return -2;
+    if (h.tested) sr_setTested(base, h.testMin, h.testMax);
 
-    // Write Header for Full Set
-    res = fprintf(f, hdrFmtFull, base->size);
+    // Raw array is one block into the file
+    res = fseek(f, 0x1000, SEEK_SET);
     if (res < 0) return -1;
 
-    // Write Header for Variable Segment
-    res = fprintf(f, hdrFmtVar, base->varSize,
-            base->mval_min, base->mval_max);
-    if (res < 0) return -1;
+    res = orFile(base, f, 0, TOTAL_B(base));
 
-    // Write Header for Fixed Segment
-    res = fprintf(f, hdrFmtFixed, base->fixedSize,
-            base->fixedv[0], base->fixedv[1],
-            base->fixedv[2], base->fixedv[3]);
-    if (res < 0) return -1;
+    return res;
+}
 
-    // Write Header Message
-    res = fprintf(f, hdrMsgData);
+// Copy Marks from a Record in a Binary File
+// Returns number of sets covered on success, -1 on error (read errno),
+// -2 on different record, -3 on invalid file
+
+// Like merging, but the file's record only needs the same set size, and
+// any sets the two have in common are ORed in. Sorted the combinadic
+// way, every record is one contiguous stretch of the sets of its size,
+// with the fixed values like the highest of the variable ones, so the
+// sets in common are one stretch of each array, and are read straight
+// across. That makes this good for splitting a record into M-ranges,
+// joining neighbouring ones, or moving between fixed values and
+// variable ones, without working anything out again. A tested range
+// must be the same as the record's, if both have one. Where the sets
+// covered start in the record is given back, as they're contiguous.
+ssize_t sr_retile(Base *base, FILE *restrict f, size_t *start)
+{
+    int res;
+
+    // Read the Header
+    Header h;
+    res = readHeader(f, &h);
+    if (res) return res;
+
+    // Has to be the same set size, and tested the same
+    if (h.size != base->size) return -2;
+    if (h.tested && base->tested && (h.testMin != base->test_min
+            || h.testMax != base->test_max)) return -2;
+
+    // Where each starts among all sets of the size
+    Place ours = place(base->varSize, base->mval_min,
+            base->fixedSize, base->fixedv);
+    Place theirs = place(h.varSize, h.minm, h.fixedSize, h.fixed);
+    Place ourEnd = ours + TOTAL_B(base);
+    Place theirEnd = theirs + TOTAL(h.minm, h.maxm, h.varSize);
+
+    // Sets in common
+    Place lo = ours > theirs ? ours : theirs;
+    Place hi = ourEnd < theirEnd ? ourEnd : theirEnd;
+    if (lo >= hi) return 0;
+    if (h.tested) sr_setTested(base, h.testMin, h.testMax);
+    *start = lo - ours;
+
+    // Read them across from where they are in the file
+    res = fseek(f, 0x1000 + (long) (lo - theirs), SEEK_SET);
     if (res < 0) return -1;
 
+    res = orFile(base, f, lo - ours, hi - lo);
+    if (res) return res;
+
+    return hi - lo;
+}
+
+// Export Record to Binary File
+// Returns 0 on success, -1 on error (read errno)
+
+// Writes a record's state to a data file, to be Imported later. The
+// counts of marked sets only go in the header if they didn't change
+// while writing the array, since otherwise they might not match it.
+int sr_export(const Base *base, FILE *restrict f)
+{
+    int res;
+
+    // Counts before writing the array
+    size_t before[BITS], after[BITS];
+    sumBits(base->counts, before);
+
+    // Anything marked from here on is newer than the file
+    size_t total = TOTAL_B(base);
+    fillDirty(base->dirty, total, 0);
+    atomic_store(base->cleared, false);
+
     // Write entire raw array one block into the file
     res = fseek(f, 0x1000, SEEK_SET);
     if (res < 0) return -1;
 
-    size_t total = TOTAL_B(base);
     size_t written = fwrite(base->rec, sizeof(Rec), total, f);
     if (written != total) return -1;
 
+    // And after
+    sumBits(base->counts, after);
+    bool counted = true;
+    for (size_t b = 0; b < BITS; b++)
+        if (before[b] != after[b]) counted = false;
+
+    // Header follows the Reserved Space
+    res = writeHeader(base, f, counted ? after : NULL);
+    if (res < 0) return -1;
+
+    return 0;
+}
+
+// Export Changes to Record into Binary File
+// Returns 0 on success, -1 on error (read errno), -2 if it has to be
+// written whole
+
+// Writes only the blocks that have changed since the record was last
+// imported or exported, over the file holding that earlier state, which
+// must be opened for reading and writing, and hold the same record. The
+// header goes first and is on disk before any of the array is written,
+// without the counts of marked sets, so if this is cut short, the file
+// still holds a record with every block either as before or as now,
+// which is a valid state as long as marks have only been added. If any
+// bits were cleared, the blocks go first and the header last instead,
+// since the new header might say more than the old blocks do, like a
+// tested range the old tested marks don't go with; a record extended
+// since the file was written has to be written whole then. If the
+// counts didn't change while writing, they go in once the array's on
+// disk too. If the record has been extended, the file's grown first,
+// and the new sets are among the blocks changed.
+int sr_export_incremental(const Base *base, FILE *restrict f)
+{
+    int res;
+
+    // Counts before writing the array, and whether anything's cleared
+    size_t before[BITS], after[BITS];
+    sumBits(base->counts, before);
+    bool cleared = atomic_exchange(base->cleared, false);
+
+    // Make sure the file holds this record, and is the right size
+    size_t total = TOTAL_B(base);
+    res = fseek(f, 0, SEEK_END);
+    if (res < 0) return -1;
+    long len = ftell(f);
+    if (len < 0) return -1;
+
+    Header h;
+    res = readHeader(f, &h);
+    if (res == -1) return -1;
+
+    // A file holding this record from before it was extended is grown
+    // to match first, the new stretch reading as unmarked until written
+    if (res == 0 && (size_t) len < 0x1000 + total && !cleared
+            && extendedFrom(base, &h, len)) {
+        if (fflush(f) || ftruncate(fileno(f), 0x1000 + total)) {
+            atomic_store(base->cleared, cleared);
+            return -1;
+        }
+    }
+    else if (res || (size_t) len != 0x1000 + total
+            || !sameRecord(base, &h)) {
+        atomic_store(base->cleared, cleared);
+        return -2;
+    }
+
+    // Header first, without the counts, unless it has to go last
+    if (!cleared) {
+        res = writeHeader(base, f, NULL);
+        if (res == 0) res = fflush(f) || fsync(fileno(f)) ? -1 : 0;
+        if (res < 0) {
+            atomic_store(base->cleared, cleared);
+            return -1;
+        }
+    }
+
+    // Then each block changed, taking its bit off first so anything
+    // marked while it's written is caught next time
+    size_t blocks = BLOCKS(total);
+    for (size_t w = 0; w < WORDS(total); w++)
+    {
+        uint64_t bits = atomic_exchange(base->dirty + w, 0);
+        for (; bits; bits &= bits - 1)
+        {
+            size_t b = w * WORD + __builtin_ctzll(bits);
+            if (b >= blocks) break;
+
+            size_t start = b * BLOCK;
+            size_t n = total - start < BLOCK ? total - start : BLOCK;
+
+            res = fseek(f, 0x1000 + start, SEEK_SET);
+            if (res == 0) res = fwrite(base->rec + start, sizeof(Rec),
+                    n, f) == n ? 0 : -1;
+
+            // Put back what's left, on error
+            if (res < 0) {
+                atomic_fetch_or(base->dirty + w, bits);
+                atomic_store(base->cleared, cleared);
+                return -1;
+            }
+        }
+    }
+
+    // And after
+    sumBits(base->counts, after);
+    bool counted = true;
+    for (size_t b = 0; b < BITS; b++)
+        if (before[b] != after[b]) counted = false;
+    if (!counted && !cleared) return 0;
+
+    // Header again with the counts, or for the first time
+    if (fflush(f) || fsync(fileno(f))) {
+        atomic_store(base->cleared, cleared);
+        return -1;
+    }
+    res = writeHeader(base, f, counted ? after : NULL);
+    if (res < 0) {
+        atomic_store(base->cleared, cleared);
+        return -1;
+    }
+
     return 0;
 }
 
@@ -452,63 +1193,169 @@ int sr_export(const Base *base, FILE *restrict f)
 // to do the calculations. They don't refer to information structures of
 // user-space.
 
+// Find a Set in a Record
+// Returns its index, -1 on error (read errno), -2 if not in the record
+
+// The user-level functions that take a set all find it here, so this
+// validates the set for them. It's in the record if its M-value is in
+// range and its fixed values match.
+ssize_t findSet(const Base *base, const SetVal *set, size_t size)
+{
+#ifndef NO_VALIDATE
+    // Validate input set: values must be positive and ascending, and
+    // size must be N
+    errno = EINVAL;
+    if (size != base->size) return -1;
+    if (set[0] < 1) return -1;
+    for (size_t i = 1; i < size; i++)
+        if (set[i] <= set[i - 1]) return -1;
+    errno = 0;
+#else
+    (void) size;
+#endif
+
+    // Skip if set M-value is out of range
+    size_t varSize = base->varSize;
+    if (set[varSize - 1] > base->mval_max
+            || set[varSize - 1] < base->mval_min) return -2;
+
+    // Skip if fixed values don't match
+    for (size_t i = 0; i < base->fixedSize; i++)
+        if (set[varSize + i] != base->fixedv[i]) return -2;
+
+    return base->kern->toIndex(set, varSize) - base->first;
+}
+
 // Mark a Set
 // Returns 1 if newly marked (new bits set), 0 if already marked
 
 // This function marks a particular set in the record, OR'ing the given
-// bits. Assumes given set is in ascending order, the right size, and in
-// the right range of values. This function only deals with the variable
-// portion of sets, as the fixed values have no bearing on anything.
-int mark(Rec *rec, unsigned long minm,
-        const unsigned long *set, size_t varSize, char mask)
+// bits. Takes the set's index in the record, which has to be in range.
+int mark(Rec *rec, Counts *counts, Dirty *dirty, size_t index,
+        char mask, char fresh)
 {
     // OR the bits we care about
-    size_t index = setToIndex(set, varSize) - mcn(minm - 1, varSize);
     char prev = atomic_fetch_or(rec + index, mask);
 
+    // Count the ones we set
+    unsigned char added = mask & ~prev;
+
+    // Note the set if it's new, which only ever happens once per set
+    if (fresh && !(prev & mask))
+        added |= fresh & ~atomic_fetch_or(rec + index, fresh);
+    if (added) {
+        Counts *shard = myShard(counts);
+        for (; added; added &= added - 1) {
+            atomic_size_t *c = shard->bits + __builtin_ctz(added);
+            atomic_fetch_add_explicit(c, 1, memory_order_relaxed);
+        }
+        setDirty(dirty, index);
+    }
+
     // Whether they were already set
     return (prev & mask) != mask;
 }
 
+// Mark Supersets from a Value Down
+// Returns the number of sets newly marked
+
+// Fills in the value at the given number of places left, which is
+// somewhere from the floor up to just under the value above it, and
+// goes on down, adding on its part of the index, marking the set once
+// every place is filled. Given values that are left have to fit in the
+// places below, and each place is either the highest of them or a value
+// above it. The index comes in counted from the first set of the size.
+size_t markSupers(const Base *base, const SetVal *sub, size_t subc,
+        size_t left, unsigned long floor, unsigned long hi,
+        size_t index, char mask, char fresh)
+{
+    size_t newc = 0;
+
+    // Lowest value that still leaves room for the places below
+    unsigned long low = subc ? sub[subc - 1] : left;
+    if (low < floor) low = floor;
+
+    for (unsigned long v = low; v < hi; v++)
+    {
+        // A value that isn't given takes up a place one would need
+        bool given = subc && v == sub[subc - 1];
+        if (!given && subc >= left) break;
+
+        if (left == 1) {
+            newc += mark(base->rec, base->counts, base->dirty,
+                    index + v - 1 - base->first, mask, fresh);
+        }
+        else newc += markSupers(base, sub, subc - given, left - 1, 0, v,
+                index + mcn(v - 1, left), mask, fresh);
+    }
+
+    return newc;
+}
+
 // Iteratively Check Records and Output Sets
 // Returns number of sets on success, -1 on error (read errno)
 
-// This is a function which looks across an entire record. It iterates
-// across all the sets, keeping a pointer to the current entry in the
-// record as well as an array of values that corresponds to that set.
-// If a set matches the bit-field criteria provided, it will be output
-// to the given function.
+// This is a function which looks across a range of a record. It
+// iterates across the sets, keeping a pointer to the current entry in
+// the record as well as an array of values that corresponds to that
+// set. If a set matches the bit-field criteria provided, it will be
+// output to the given function.
 
 // The function also can be configured for running in parallel. It gives
 // an option for querying every Nth element. Additionally, it can give
 // periodic progress tracking by updating an object with the number of
-// sets remaining.
-ssize_t query(const Rec *rec,
-        unsigned long minm, unsigned long maxm, size_t varSize,
+// sets elapsed. Every set before that number has been output, and
+// anything done with it is visible to whoever reads the number.
+ssize_t query(const Rec *rec, unsigned long minm, size_t varSize,
         const unsigned long *fixedv, size_t fixedSize,
-        size_t offset, size_t skip, char mask, char bits,
-        size_t *progress, size_t period, OutFun *out)
+        size_t start, size_t end, size_t skip, char mask, char bits,
+        atomic_size_t *progress, size_t period, OutFun *out)
 {
     // Number of Sets
     ssize_t setc = 0;
 
+    // Nothing to do on an empty range
+    if (start >= end) {
+        if (progress != NULL)
+            atomic_store_explicit(progress, 0, memory_order_relaxed);
+        return 0;
+    }
+
+    // With nowhere to output, only the marks matter
+    if (out == NULL) {
+        for (size_t i = start; i < end; i += skip)
+        {
+            char cur = atomic_load_explicit(rec + i,
+                    memory_order_relaxed);
+            if (mask != 0) setc += (cur & mask) == (bits & mask);
+            else setc += (cur & bits) != 0 || bits == 0;
+
+            if (progress != NULL) if ((i - start) / skip % period == 0)
+                atomic_store_explicit(progress, (i - start) / skip,
+                        memory_order_release);
+        }
+
+        if (progress != NULL)
+            atomic_store_explicit(progress, (end - start - 1) / skip + 1,
+                    memory_order_release);
+
+        return setc;
+    }
+
     // The set representation we'll use
     size_t size = varSize + fixedSize;
-    unsigned long *values = calloc(size, sizeof(unsigned long));
+    SetVal *values = calloc(size, sizeof(SetVal));
     if (values == NULL) return -1;
 
-    // The representation of the first allocated set, including fixed
-    // values, adjusted to our starting point
-    indexToSet(values, varSize - 1, 0);
-    values[varSize - 1] = minm;
+    // The representation of the set at our starting point, including
+    // fixed values
+    indexToSet(values, varSize, start + mcn(minm - 1, varSize));
     for (size_t i = 0; i < fixedSize; i++)
         values[varSize + i] = fixedv[i];
-    incSetValues(values, size, offset);
 
     // Loop over every Nth set, checking, outputting, and updating
     // progress
-    size_t total = TOTAL(minm, maxm, varSize);
-    for (size_t i = offset; i < total; i += skip)
+    for (size_t i = start; i < end; i += skip)
     {
         bool match = false;
 
@@ -534,12 +1381,15 @@ ssize_t query(const Rec *rec,
         incSetValues(values, varSize, skip);
 
         // Update Progress every so often
-        if (progress != NULL) if (i / skip % period == 0)
-            *progress = i / skip;
+        if (progress != NULL) if ((i - start) / skip % period == 0)
+            atomic_store_explicit(progress, (i - start) / skip,
+                    memory_order_release);
     }
 
     // Final progress update
-    if (progress != NULL) *progress = (total - offset - 1) / skip + 1;
+    if (progress != NULL)
+        atomic_store_explicit(progress, (end - start - 1) / skip + 1,
+                memory_order_release);
 
     free(values);
 
@@ -548,7 +1398,7 @@ ssize_t query(const Rec *rec,
 
 // Compute Index from Set
 // Returns the index, no error checking
-size_t setToIndex(const unsigned long *set, size_t varSize)
+size_t setToIndex(const SetVal *set, size_t varSize)
 {
     size_t index = 0;
 
@@ -566,7 +1416,7 @@ size_t setToIndex(const unsigned long *set, size_t varSize)
 
 // Compute Set from Index
 // Set is written into given array pointer
-void indexToSet(unsigned long *set, size_t varSize, size_t index)
+void indexToSet(SetVal *set, size_t varSize, size_t index)
 {
     // Go from most significant (highest) to least
     for (size_t vals = varSize; vals > 0; vals--)
@@ -594,7 +1444,7 @@ void indexToSet(unsigned long *set, size_t varSize, size_t index)
 // so, and otherwise it'll increment the next value, using a loop to
 // deal with chains of overflowing place values. It'll repeat this
 // process until it's able to settle the first value.
-void incSetValues(unsigned long *set, size_t varSize, size_t add)
+void incSetValues(SetVal *set, size_t varSize, size_t add)
 {
     // Handle Trivial Size Cases
     if (varSize == 0);
@@ -651,3 +1501,316 @@ unsigned long long mcn(size_t m, size_t n)
 
     return total / perms;
 }
+
+// Get this Thread's Shard of Counters
+// Returns the shard
+
+// Threads are handed out shards in turn the first time they mark
+// anything, wrapping around if there are more threads than shards.
+Counts *myShard(Counts *counts)
+{
+    static atomic_size_t next = 0;
+    static _Thread_local size_t shard = SHARDS;
+
+    if (shard == SHARDS) shard = atomic_fetch_add(&next, 1) % SHARDS;
+
+    return counts + shard;
+}
+
+// Count Every Set with each Bit Marked
+
+// Scans the whole array, putting the counts in the first shard and
+// clearing the rest.
+void countBits(const Rec *rec, size_t total, Counts *counts)
+{
+    size_t c[BITS] = {0};
+    for (size_t i = 0; i < total; i++)
+    {
+        unsigned char cur = atomic_load_explicit(rec + i,
+                memory_order_relaxed);
+        for (; cur; cur &= cur - 1) c[__builtin_ctz(cur)]++;
+    }
+
+    for (size_t i = 0; i < SHARDS; i++)
+        for (size_t b = 0; b < BITS; b++)
+            atomic_store(&counts[i].bits[b], i == 0 ? c[b] : 0);
+
+    return;
+}
+
+// Add Up the Shards of Counters
+void sumBits(const Counts *counts, size_t sums[BITS])
+{
+    for (size_t b = 0; b < BITS; b++) sums[b] = 0;
+
+    for (size_t i = 0; i < SHARDS; i++)
+        for (size_t b = 0; b < BITS; b++)
+            sums[b] += atomic_load_explicit(&counts[i].bits[b],
+                    memory_order_relaxed);
+
+    return;
+}
+
+// Note a Block has Changed
+
+// Checks the block's bit before setting it, so once a block's dirty,
+// marking in it doesn't write to the shared word. The check has to see
+// the bit being taken off before a write of the block starts, so it
+// can't be relaxed.
+void setDirty(Dirty *dirty, size_t index)
+{
+    size_t block = index / BLOCK;
+    uint64_t bit = (uint64_t) 1 << block % WORD;
+
+    if (!(atomic_load(dirty + block / WORD) & bit))
+        atomic_fetch_or(dirty + block / WORD, bit);
+
+    return;
+}
+
+// Set Every Word of Dirty Bits
+void fillDirty(Dirty *dirty, size_t total, uint64_t bits)
+{
+    for (size_t w = 0; w < WORDS(total); w++)
+        atomic_store(dirty + w, bits);
+
+    return;
+}
+
+// Read the Header
+// Returns 0 on success, -1 on error (read errno), -3 on invalid file
+
+// The tested range and counts of marked sets are optional, and noted
+// as missing if they aren't there.
+int readHeader(FILE *restrict f, Header *h)
+{
+    int res;
+
+    // Header follows the Reserved Space
+    res = fseek(f, 0x0800, SEEK_SET);
+    if (res < 0) return -1;
+
+    // Read Numbers for Full Set
+    res = fscanf(f, hdrFmtFull, &h->size);
+    if (res == EOF && ferror(f)) return -1;
+    else if (res != 1) return -3;
+
+    // Read Numbers for Variable Segment
+    res = fscanf(f, hdrFmtVar, &h->varSize, &h->minm, &h->maxm);
+    if (res == EOF && ferror(f)) return -1;
+    else if (res != 3) return -3;
+
+    // Read Numbers for Fixed Segment
+    unsigned long *fixed = h->fixed;
+    res = fscanf(f, hdrFmtFixed, &h->fixedSize,
+            fixed, fixed + 1, fixed + 2, fixed + 3);
+    if (res == EOF && ferror(f)) return -1;
+    else if (res != 5) return -3;
+
+    // Read Tested Range, if there is one
+    res = fscanf(f, hdrFmtTested, &h->testMin, &h->testMax);
+    if (res == EOF && ferror(f)) return -1;
+    h->tested = res == 2;
+
+    // Read Previous M-Value, if it's been Extended
+    res = fscanf(f, hdrFmtExtended, &h->prevMax);
+    if (res == EOF && ferror(f)) return -1;
+    h->extended = res == 1;
+
+    // Read Counts of Marked Sets, if they're there
+    size_t *c = h->c;
+    res = fscanf(f, hdrFmtMarked,
+            c, c + 1, c + 2, c + 3, c + 4, c + 5, c + 6, c + 7);
+    if (res == EOF && ferror(f)) return -1;
+    h->counted = res == BITS;
+
+    return 0;
+}
+
+// Write the Header
+// Returns 0 on success, -1 on error (read errno)
+
+// The header goes in the reserved space before the array, padded out
+// with zeros, in a single write. The counts of marked sets are left out
+// if not given.
+int writeHeader(const Base *base, FILE *restrict f, const size_t *c)
+{
+    char hdr[0x800] = {0};
+    size_t len = 0;
+
+    // Full Set, Variable Segment, and Fixed Segment
+    len += snprintf(hdr + len, sizeof(hdr) - len, hdrFmtFull,
+            base->size);
+    len += snprintf(hdr + len, sizeof(hdr) - len, hdrFmtVar,
+            base->varSize, base->mval_min, base->mval_max);
+    len += snprintf(hdr + len, sizeof(hdr) - len, hdrFmtFixed,
+            base->fixedSize, base->fixedv[0], base->fixedv[1],
+            base->fixedv[2], base->fixedv[3]);
+
+    // Tested Range if there is one
+    if (base->tested)
+        len += snprintf(hdr + len, sizeof(hdr) - len, hdrFmtTested,
+                base->test_min, base->test_max);
+
+    // Previous M-Value if it's been Extended
+    if (base->prev_max)
+        len += snprintf(hdr + len, sizeof(hdr) - len, hdrFmtExtended,
+                base->prev_max);
+
+    // Counts if given
+    if (c != NULL)
+        len += snprintf(hdr + len, sizeof(hdr) - len, hdrFmtMarked,
+                c[0], c[1], c[2], c[3], c[4], c[5], c[6], c[7]);
+
+    // Message
+    snprintf(hdr + len, sizeof(hdr) - len, "%s", hdrMsgData);
+
+    int res = fseek(f, 0x0800, SEEK_SET);
+    if (res < 0) return -1;
+    if (fwrite(hdr, 1, sizeof(hdr), f) != sizeof(hdr)) return -1;
+
+    return 0;
+}
+
+// Check a File Holds this Record from before it was Extended
+// Returns whether it does
+
+// Takes the file's header and length. Everything about the record has
+// to match but the maximum M-value, which has to be lower, and the file
+// has to be long enough to hold all the sets up to it.
+bool extendedFrom(const Base *base, const Header *h, long len)
+{
+    if (h->size != base->size || h->varSize != base->varSize)
+        return false;
+    if (h->minm != base->mval_min || h->maxm >= base->mval_max)
+        return false;
+    if (h->fixedSize != base->fixedSize) return false;
+    for (size_t i = 0; i < h->fixedSize; i++)
+        if (h->fixed[i] != base->fixedv[i]) return false;
+
+    size_t total = TOTAL(h->minm, h->maxm, h->varSize);
+    return (size_t) len == 0x1000 + total;
+}
+
+// Check a File Holds the Same Record
+// Returns whether it does
+
+// The same sizes, M-range and fixed values, so its array lines up with
+// this one set for set.
+bool sameRecord(const Base *base, const Header *h)
+{
+    if (h->size != base->size || h->varSize != base->varSize)
+        return false;
+    if (h->minm != base->mval_min || h->maxm != base->mval_max)
+        return false;
+    if (h->fixedSize != base->fixedSize) return false;
+    for (size_t i = 0; i < h->fixedSize; i++)
+        if (h->fixed[i] != base->fixedv[i]) return false;
+
+    return true;
+}
+
+// OR a Stretch of a File into the Record
+// Returns 0 on success, -1 on error (read errno), -3 on a short file
+
+// Reads from wherever the file's at, into the record from the given
+// index, a stretch of blocks at a time. Only the blocks that gain
+// anything are counted and noted as changed. The counts are kept up
+// even if this is cut short.
+int orFile(Base *base, FILE *restrict f, size_t start, size_t len)
+{
+    int res = 0;
+
+    unsigned char *buf = malloc(MERGE * BLOCK);
+    if (buf == NULL) return -1;
+
+    // Stretches end on block boundaries in the record
+    size_t added[BITS] = {0};
+    for (size_t at = start; at < start + len; )
+    {
+        size_t n = (at / BLOCK + MERGE) * BLOCK - at;
+        if (n > start + len - at) n = start + len - at;
+        if (fread(buf, 1, n, f) != n) {
+            res = ferror(f) ? -1 : -3;
+            break;
+        }
+
+        for (size_t b = 0; b < n; ) {
+            size_t bn = (at + b) / BLOCK * BLOCK + BLOCK - (at + b);
+            if (bn > n - b) bn = n - b;
+            if (orBlock(base->rec + at + b, buf + b, bn, added))
+                setDirty(base->dirty, at + b);
+            b += bn;
+        }
+        at += n;
+    }
+    free(buf);
+
+    for (size_t b = 0; b < BITS; b++)
+        atomic_fetch_add(&base->counts[0].bits[b], added[b]);
+
+    return res;
+}
+
+// OR a Block of Bits from a File into the Record
+// Returns the number of vectors that gained anything
+
+// Goes a vector at a time, only writing back and counting the new bits
+// where there are any, so stretches already marked just get compared.
+size_t orBlock(Rec *rec, const unsigned char *src, size_t len,
+        size_t added[BITS])
+{
+    unsigned char *dst = (unsigned char *) rec;
+    size_t gains = 0;
+
+    for (size_t i = 0; i < len; i += sizeof(Vec))
+    {
+        size_t n = len - i < sizeof(Vec) ? len - i : sizeof(Vec);
+        Vec d = {0}, s = {0};
+        memcpy(&d, dst + i, n);
+        memcpy(&s, src + i, n);
+
+        // Skip if nothing new
+        Vec gained = s & ~d;
+        uint64_t any[sizeof(Vec) / sizeof(uint64_t)];
+        memcpy(any, &gained, sizeof(Vec));
+        uint64_t anyc = 0;
+        for (size_t w = 0; w < sizeof(Vec) / sizeof(uint64_t); w++)
+            anyc |= any[w];
+        if (!anyc) continue;
+
+        for (size_t j = 0; j < n; j++)
+            for (unsigned char g = gained[j]; g; g &= g - 1)
+                added[__builtin_ctz(g)]++;
+
+        d |= s;
+        memcpy(dst + i, &d, n);
+        gains++;
+    }
+
+    return gains;
+}
+
+// Find Where a Record Starts among All Sets of its Size
+
+// The index of its first set, with the fixed values as the highest
+// values of the set. Choices are worked out in steps so they don't go
+// out of range before the result does.
+Place place(size_t varSize, unsigned long minm, size_t fixedSize,
+        const unsigned long *fixed)
+{
+    Place index = 0;
+
+    for (size_t v = 0; v <= fixedSize; v++)
+    {
+        size_t n = varSize + v;
+        unsigned long m = v ? fixed[v - 1] - 1 : minm - 1;
+
+        Place choices = m >= n;
+        for (size_t i = 0; i < n && m >= n; i++)
+            choices = choices * (m - i) / (i + 1);
+        index += choices;
+    }
+
+    return index;
+}
@@ -5,10 +5,13 @@
 #ifndef SETREC_H
 #define SETREC_H
 
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <sys/types.h>
 
+#include "setVal.h"
+
 // Set Record Information Structure
 typedef struct Base SR_Base;
 
@@ -19,6 +22,9 @@ SR_Base *sr_initialize(size_t);
 int sr_alloc(SR_Base *, size_t, unsigned long, unsigned long,
         size_t, const unsigned long *);
 
+// Extend a Set Record's M-Range
+int sr_extend(SR_Base *, unsigned long);
+
 // Release a Set Record
 void sr_release(SR_Base *);
 
@@ -30,23 +36,73 @@ unsigned long sr_getMaxM(const SR_Base *);
 size_t sr_getFixedSize(const SR_Base *);
 unsigned long sr_getFixedValue(const SR_Base *, size_t);
 size_t sr_getTotal(const SR_Base *);
+int sr_getTested(const SR_Base *, unsigned long *, unsigned long *);
+int sr_getExtended(const SR_Base *, unsigned long *, size_t *);
+size_t sr_getMarked(const SR_Base *, char);
+size_t sr_getIndex(const SR_Base *, const SetVal *);
+int sr_getBits(const SR_Base *, const SetVal *, size_t);
+
+// Set Record Properties
+void sr_setTested(SR_Base *, unsigned long, unsigned long);
+void sr_clearExtended(SR_Base *);
 
 // Mark a Certain Set and Supersets
-int sr_mark(const SR_Base *, const unsigned long *, size_t,
+int sr_mark(const SR_Base *, const SetVal *, size_t,
         char);
 
+// Mark a Certain Set, Noting it if New
+int sr_markFresh(const SR_Base *, const SetVal *, size_t,
+        char, char);
+
+// Mark a Certain Set Only this Thread Marks
+int sr_markOwn(const SR_Base *, const SetVal *, size_t,
+        char, char);
+
+// Mark Every Superset of a Set
+ssize_t sr_markSupersets(const SR_Base *, const SetVal *, size_t,
+        char, char);
+
+// Clear Bits on Every Set
+void sr_clear(const SR_Base *, char);
+
+// Mark Bits on Every Set
+void sr_fill(const SR_Base *, char);
+
+// Clear Bits on a Slice of Sets
+void sr_clear_slice(const SR_Base *, char, size_t, size_t);
+
 // Output Sets with Particular Mark Status
-ssize_t sr_query(const SR_Base *, char, char,
-        size_t *, void (*)(const unsigned long *, size_t, char));
+ssize_t sr_query(const SR_Base *, char, char, atomic_size_t *,
+        void (*)(const SetVal *, size_t, char));
 
 // Output Sets with Particular Mark Status, for Parallelism
 ssize_t sr_query_parallel(const SR_Base *, char, char, size_t, size_t,
-        size_t *, void (*)(const unsigned long *, size_t, char));
+        atomic_size_t *,
+        void (*)(const SetVal *, size_t, char));
+
+// Output Sets with Particular Mark Status, for Parallelism, over a Slice
+ssize_t sr_query_slice(const SR_Base *, char, char, size_t, size_t,
+        size_t, size_t, atomic_size_t *,
+        void (*)(const SetVal *, size_t, char));
+
+// Output Sets with Particular Mark Status, over a Range
+ssize_t sr_query_range(const SR_Base *, char, char, size_t, size_t,
+        atomic_size_t *,
+        void (*)(const SetVal *, size_t, char));
 
 // Import Record from Binary FIle
 int sr_import(SR_Base *, FILE *restrict);
 
+// Merge a Record from a Binary File
+int sr_merge(SR_Base *, FILE *restrict);
+
+// Copy Marks from a Record in a Binary File
+ssize_t sr_retile(SR_Base *, FILE *restrict, size_t *);
+
 // Export Record to Binary File
 int sr_export(const SR_Base *, FILE *restrict);
 
+// Export Changes to Record into Binary File
+int sr_export_incremental(const SR_Base *, FILE *restrict);
+
 #endif
@@ -0,0 +1,35 @@
+// ============================= SET VALUES ============================
+
+// The type that the values of a set are passed around as, between the
+// libraries and the programs. M-values never get very large, so sets
+// are kept narrower than a machine word, and more of them fit into the
+// cache and into a vector register. How narrow is chosen when building,
+// by defining SET_VAL_BITS as 16, 32 or 64, the default being 32. Only
+// the sets themselves are narrowed; M-ranges, fixed values and anything
+// worked out from a set's values are still held as unsigned longs, and
+// records can't be made with values too large for the type.
+
+#ifndef SETVAL_H
+#define SETVAL_H
+
+#include <stdint.h>
+
+#ifndef SET_VAL_BITS
+#define SET_VAL_BITS 32
+#endif
+
+// Value of a Set, and the Largest it can Hold
+#if SET_VAL_BITS == 16
+typedef uint16_t SetVal;
+#define SET_VAL_MAX UINT16_MAX
+#elif SET_VAL_BITS == 32
+typedef uint32_t SetVal;
+#define SET_VAL_MAX UINT32_MAX
+#elif SET_VAL_BITS == 64
+typedef uint64_t SetVal;
+#define SET_VAL_MAX UINT64_MAX
+#else
+#error "SET_VAL_BITS must be 16, 32 or 64"
+#endif
+
+#endif
@@ -0,0 +1,352 @@
+// ============================== STREAM ===============================
+
+// Copyright (c) 2023, Jacob Bates
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This library writes out the sets in a record with some mark status,
+// as fast as the file they're going to can take them. When millions of
+// sets are left, printing each value on its own through the standard
+// library spends far longer formatting than writing, so here, the
+// record is split into chunks that a few threads query at once, each
+// formatting its sets into a large buffer of its own by hand, and the
+// buffers are written out whole.
+
+// The sets can come out in the same order as they are in the record,
+// in which case each thread holds on to a chunk's worth until the
+// chunks before it are written, or in whatever order the threads get to
+// them, in which case each thread writes its buffer whenever it fills
+// up. Unordered output needs less waiting and less memory, but the
+// same sets come out either way.
+
+// Sets can be written as text, in columns like the programs normally
+// show them or split by commas, or as binary, either each value as a
+// `SetVal', as wide as it was built to be, so no value is cut short, or
+// just where the set is in the record as a 64-bit integer, which is
+// enough to get the set back given the record. Binary is in this
+// machine's byte order, with nothing around it.
+
+#define _DEFAULT_SOURCE
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <errno.h>
+#include <pthread.h>
+
+#include "setRec.h"
+#include "stream.h"
+
+// Sets per Chunk, Bytes a Buffer Holds before Writing when Unordered
+#define CHUNK 0x10000
+#define FLUSH 0x100000
+
+// The Whole Dump
+typedef struct Dump {
+    const SR_Base *rec;
+    char mask;
+    char bits;
+    FILE *f;
+    ST_Format format;
+    bool ordered;
+    size_t chunks;
+    atomic_size_t nextChunk;
+    pthread_mutex_t lock;           // guards the rest, and the file
+    pthread_cond_t turn;
+    size_t written;                 // chunks written, when ordered
+    int err;                        // first error, if any
+} Dump;
+
+// A Thread's Share
+typedef struct Worker {
+    Dump *dump;
+    pthread_t thread;
+    ssize_t setc;
+    char *buf;
+    size_t len;
+    size_t cap;
+    bool full;                      // couldn't make room in buffer
+} Worker;
+
+// The Calling Thread's Share
+static _Thread_local Worker *me = NULL;
+
+// Helper Function Declarations
+static void *work(void *);
+static void format(const SetVal *, size_t, char);
+static char *putNum(char *, unsigned long, size_t);
+static int flush(Worker *);
+static bool failed(Dump *);
+static void fail(Dump *, int);
+
+// Write Out Sets with Particular Mark Status
+// Returns number of sets on success, -1 on error (read errno)
+
+// The sets are picked the same way as querying the record. The given
+// number of threads share the work, the calling thread being one. Once
+// this returns, everything has been handed to the file, and it's been
+// flushed.
+ssize_t st_dump(const SR_Base *rec, char mask, char bits, FILE *f,
+        ST_Format format, bool ordered, size_t threads)
+{
+#ifndef NO_VALIDATE
+    // Validate Parameters
+    errno = EINVAL;
+    if (threads < 1 || format > ST_RANKS) return -1;
+    errno = 0;
+#endif
+
+    size_t total = sr_getTotal(rec);
+    Dump dump = {
+        .rec = rec, .mask = mask, .bits = bits, .f = f,
+        .format = format, .ordered = ordered,
+        .chunks = (total + CHUNK - 1) / CHUNK,
+        .written = 0, .err = 0
+    };
+    atomic_init(&dump.nextChunk, 0);
+    pthread_mutex_init(&dump.lock, NULL);
+    pthread_cond_init(&dump.turn, NULL);
+
+    Worker *workers = calloc(threads, sizeof(Worker));
+    if (workers == NULL) return -1;
+
+    // Start the others, then join in
+    size_t started = 1;
+    for (size_t i = 0; i < threads; i++)
+        workers[i].dump = &dump;
+    for (; started < threads; started++) {
+        int res = pthread_create(&workers[started].thread, NULL,
+                &work, workers + started);
+        if (res) {
+            fail(&dump, res);
+            break;
+        }
+    }
+    work(workers);
+
+    ssize_t setc = 0;
+    for (size_t i = 0; i < started; i++) {
+        if (i) pthread_join(workers[i].thread, NULL);
+        setc += workers[i].setc;
+    }
+    free(workers);
+
+    pthread_cond_destroy(&dump.turn);
+    pthread_mutex_destroy(&dump.lock);
+
+    if (!dump.err && fflush(f)) dump.err = errno ? errno : EIO;
+    if (dump.err) {
+        errno = dump.err;
+        return -1;
+    }
+
+    return setc;
+}
+
+// ============ Helper Functions
+
+// Work on Chunks until There are None Left
+
+// Each chunk is queried into the thread's buffer. When ordered, the
+// buffer's written once the chunks before it have been, and otherwise,
+// whenever it fills up, and at the end.
+void *work(void *arg)
+{
+    Worker *w = arg;
+    Dump *d = w->dump;
+    me = w;
+
+    w->cap = d->ordered ? 0 : FLUSH;
+    w->buf = malloc(w->cap + 1);
+    if (w->buf == NULL) {
+        fail(d, errno);
+        return NULL;
+    }
+
+    while (!failed(d))
+    {
+        size_t c = atomic_fetch_add(&d->nextChunk, 1);
+        if (c >= d->chunks) break;
+
+        ssize_t res = sr_query_range(d->rec, d->mask, d->bits,
+                c * CHUNK, (c + 1) * CHUNK, NULL, &format);
+        if (res < 0 || w->full) {
+            fail(d, res < 0 ? errno : ENOMEM);
+            break;
+        }
+        w->setc += res;
+
+        if (!d->ordered) continue;
+
+        // Wait for the chunks before this one
+        pthread_mutex_lock(&d->lock);
+        while (d->written != c && !d->err)
+            pthread_cond_wait(&d->turn, &d->lock);
+        if (!d->err) {
+            errno = 0;
+            if (fwrite(w->buf, 1, w->len, d->f) < w->len)
+                d->err = errno ? errno : EIO;
+            d->written++;
+        }
+        pthread_cond_broadcast(&d->turn);
+        pthread_mutex_unlock(&d->lock);
+        w->len = 0;
+    }
+
+    if (!d->ordered && w->len && flush(w)) fail(d, errno);
+
+    free(w->buf);
+    me = NULL;
+
+    return NULL;
+}
+
+// Format a Set into the Calling Thread's Buffer
+
+// A query output function. There's no way to return an error from
+// here, so if there's no room for the set, it's noted and the set
+// dropped.
+void format(const SetVal *set, size_t size, char bits)
+{
+    (void) bits;
+
+    Worker *w = me;
+    Dump *d = w->dump;
+    if (w->full) return;
+
+    // Make room for the largest this set could be
+    size_t need = w->len + size * ST_VAL_BYTES + 1;
+    if (need > w->cap)
+    {
+        if (!d->ordered) {
+            if (flush(w)) {
+                fail(d, errno);
+                w->full = true;
+                return;
+            }
+        }
+        else {
+            size_t cap = w->cap ? w->cap * 2 : FLUSH;
+            while (cap < need) cap *= 2;
+            char *buf = realloc(w->buf, cap);
+            if (buf == NULL) {
+                w->full = true;
+                return;
+            }
+            w->buf = buf;
+            w->cap = cap;
+        }
+    }
+
+    char *p = w->buf + w->len;
+    if (d->format == ST_RANKS) {
+        uint64_t index = sr_getIndex(d->rec, set);
+        memcpy(p, &index, sizeof(index));
+        p += sizeof(index);
+    }
+    else p = st_putSet(p, set, size, d->format);
+    w->len = p - w->buf;
+
+    return;
+}
+
+// Format a Set into a Buffer
+// Returns where the set ends
+
+// Writes the set's values in any format but ranks, which need the
+// record. There has to be room for the most the set could take, the
+// value bytes for each value and a newline.
+char *st_putSet(char *p, const SetVal *set, size_t size,
+        ST_Format format)
+{
+    switch (format)
+    {
+    case ST_TEXT:
+        for (size_t i = 0; i < size; i++)
+            p = putNum(p, set[i], 4);
+        *p++ = '\n';
+        break;
+
+    case ST_CSV:
+        for (size_t i = 0; i < size; i++) {
+            if (i) *p++ = ',';
+            p = putNum(p, set[i], 0);
+        }
+        *p++ = '\n';
+        break;
+
+    case ST_VALUES:
+        memcpy(p, set, size * sizeof(SetVal));
+        p += size * sizeof(SetVal);
+        break;
+
+    case ST_RANKS:
+        break;
+    }
+
+    return p;
+}
+
+// Write a Number in Decimal
+// Returns where the number ends
+
+// Padded on the left with spaces to at least the given width.
+char *putNum(char *p, unsigned long v, size_t width)
+{
+    char digits[20];
+    size_t n = 0;
+    do digits[n++] = '0' + v % 10;
+    while (v /= 10);
+
+    for (; width > n; width--) *p++ = ' ';
+    while (n) *p++ = digits[--n];
+
+    return p;
+}
+
+// Write Out a Thread's Buffer
+// Returns 0 on success, -1 on error (read errno)
+int flush(Worker *w)
+{
+    Dump *d = w->dump;
+
+    pthread_mutex_lock(&d->lock);
+    errno = 0;
+    size_t res = fwrite(w->buf, 1, w->len, d->f);
+    pthread_mutex_unlock(&d->lock);
+
+    if (res < w->len) {
+        if (!errno) errno = EIO;
+        return -1;
+    }
+    w->len = 0;
+
+    return 0;
+}
+
+// Whether Something's Gone Wrong
+bool failed(Dump *d)
+{
+    pthread_mutex_lock(&d->lock);
+    bool res = d->err != 0;
+    pthread_mutex_unlock(&d->lock);
+
+    return res;
+}
+
+// Note Something's Gone Wrong
+
+// Only the first error is kept. Anyone waiting for their turn is woken
+// to give up.
+void fail(Dump *d, int err)
+{
+    pthread_mutex_lock(&d->lock);
+    if (!d->err) d->err = err ? err : EIO;
+    pthread_cond_broadcast(&d->turn);
+    pthread_mutex_unlock(&d->lock);
+
+    return;
+}
@@ -0,0 +1,33 @@
+// ============================== STREAM ===============================
+
+// See more info about this library in the source file `stream.c'.
+
+#ifndef STREAM_H
+#define STREAM_H
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/types.h>
+
+#include "setRec.h"
+
+// Output Formats
+typedef enum ST_Format {
+    ST_TEXT = 0,            // values in columns, a set per line
+    ST_CSV,                 // values split by commas, a set per line
+    ST_VALUES,              // values as SetVal-width integers
+    ST_RANKS                // indexes in the record as 64-bit integers
+} ST_Format;
+
+// Most Bytes a Value Takes as Text, with a Separator
+#define ST_VAL_BYTES 21
+
+// Write Out Sets with Particular Mark Status
+ssize_t st_dump(const SR_Base *, char, char, FILE *, ST_Format, bool,
+        size_t);
+
+// Format a Set into a Buffer
+char *st_putSet(char *, const SetVal *, size_t, ST_Format);
+
+#endif
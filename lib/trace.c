@@ -0,0 +1,326 @@
+// =============================== TRACE ===============================
+
+// Copyright (c) 2023, Jacob Bates
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This library is for seeing what each thread of a program spent its
+// time on, when a run is slower than it should be. Spans of time are
+// noted on the thread they happened on, with a name, and at the end,
+// they're all written out in the trace event format Chrome and Perfetto
+// can show as a timeline, with a row for each thread. That shows at a
+// glance whether the threads had about the same amount of work, and
+// where any of them sat waiting.
+
+// Each thread keeps its spans in its own buffer, which it only ever
+// writes to itself, so noting a span takes no locks and touches nothing
+// shared. The buffer is a ring, so a long run keeps its latest spans and
+// the memory stays bounded. Each thread also keeps the few slowest sets
+// it was asked to note, with the set itself, so the worst cases show up
+// without noting every set. Work done a set at a time can be noted in
+// batches, one span for every so many sets, so the timeline shows how
+// quickly it went without a span for each. Nothing is written until the
+// end, when the threads are done. Tracing is off unless started, and
+// until then, every call returns straight away.
+
+#define _DEFAULT_SOURCE
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <pthread.h>
+#include <unistd.h>
+
+#include "trace.h"
+
+// Spans Kept per Thread, Slowest Sets Kept per Thread
+#define RING 0x10000
+#define SLOWEST 16
+#define SET_MAX 8
+
+// A Span of Time
+typedef struct Span {
+    const char *name;
+    uint64_t start;
+    uint64_t end;
+} Span;
+
+// A Set that Took a While
+typedef struct Slow {
+    const char *name;
+    uint64_t start;
+    uint64_t end;
+    size_t size;
+    SetVal set[SET_MAX];
+} Slow;
+
+// Buffer for One Thread
+typedef struct Ring Ring;
+struct Ring {
+    Ring *next;
+    size_t tid;
+    char name[32];
+    size_t count;           // spans ever noted
+    Span spans[RING];
+    size_t slowc;
+    Slow slow[SLOWEST];
+    const char *batch;      // batch being noted, if any
+    size_t batchc;
+    uint64_t batchStart;
+    uint64_t batchEnd;
+};
+
+// Whether Tracing is On
+bool tr_enabled = false;
+
+// Output File, Start Time, and Every Thread's Buffer
+static char *fname = NULL;
+static uint64_t origin;
+static Ring *rings = NULL;
+static size_t ringc = 0;
+static pthread_mutex_t ringLock = PTHREAD_MUTEX_INITIALIZER;
+static _Thread_local Ring *ring = NULL;
+
+// Helper Function Declarations
+static Ring *myRing(void);
+static void writeSpan(FILE *, const Ring *, const char *,
+        uint64_t, uint64_t, bool *);
+
+// Start Tracing
+// Returns 0 on success, -1 on error (read errno)
+
+// Spans are noted from here on, and written to the given file when
+// finished.
+int tr_start(const char *out)
+{
+    fname = strdup(out);
+    if (fname == NULL) return -1;
+
+    origin = tr_now();
+    tr_enabled = true;
+
+    return 0;
+}
+
+// Finish Tracing and Write it Out
+// Returns 0 on success, -1 on error (read errno)
+
+// Every thread that noted anything should be done by now. The buffers
+// are freed either way.
+int tr_finish(void)
+{
+    if (!tr_enabled) return 0;
+    tr_enabled = false;
+
+    int res = 0;
+    FILE *f = fopen(fname, "w");
+    if (f == NULL) res = -1;
+
+    // Events for each thread
+    bool first = true;
+    if (f != NULL) fprintf(f, "{\"traceEvents\": [\n");
+    for (Ring *r = rings; r != NULL && f != NULL; r = r->next)
+    {
+        // Thread name
+        fprintf(f, "%s{\"name\": \"thread_name\", \"ph\": \"M\", "
+                "\"pid\": %ld, \"tid\": %zu, "
+                "\"args\": {\"name\": \"%s\"}}",
+                first ? "" : ",\n", (long) getpid(), r->tid, r->name);
+        first = false;
+
+        // Spans, oldest first
+        size_t n = r->count < RING ? r->count : RING;
+        for (size_t i = r->count - n; i < r->count; i++) {
+            const Span *s = r->spans + i % RING;
+            writeSpan(f, r, s->name, s->start, s->end, &first);
+            fprintf(f, "}");
+        }
+
+        // Slowest sets, with the sets themselves
+        for (size_t i = 0; i < r->slowc; i++) {
+            const Slow *s = r->slow + i;
+            writeSpan(f, r, s->name, s->start, s->end, &first);
+            fprintf(f, ", \"cat\": \"slow\", \"args\": {\"set\": \"");
+            for (size_t v = 0; v < s->size; v++)
+                fprintf(f, v ? " %lu" : "%lu",
+                        (unsigned long) s->set[v]);
+            fprintf(f, "\"}}");
+        }
+    }
+
+    if (f != NULL) {
+        fprintf(f, "\n], \"displayTimeUnit\": \"ms\"}\n");
+        if (fclose(f)) res = -1;
+    }
+
+    // Free everything
+    while (rings != NULL) {
+        Ring *next = rings->next;
+        free(rings);
+        rings = next;
+    }
+    ringc = 0;
+    ring = NULL;
+    free(fname);
+    fname = NULL;
+
+    return res;
+}
+
+// Name the Calling Thread
+void tr_thread(const char *name)
+{
+    if (!tr_enabled) return;
+
+    Ring *r = myRing();
+    if (r == NULL) return;
+    strncpy(r->name, name, sizeof(r->name) - 1);
+    r->name[sizeof(r->name) - 1] = '\0';
+
+    return;
+}
+
+// Note a Span on the Calling Thread
+
+// The name isn't copied, so it should be a string literal or otherwise
+// last until tracing's finished. Times are from tr_now().
+void tr_span(const char *name, uint64_t start, uint64_t end)
+{
+    if (!tr_enabled) return;
+
+    Ring *r = myRing();
+    if (r == NULL) return;
+
+    Span *s = r->spans + r->count++ % RING;
+    s->name = name;
+    s->start = start;
+    s->end = end;
+
+    return;
+}
+
+// Note Work Towards a Batch
+
+// Adds the time given to the calling thread's batch, and once it has
+// the given number of pieces of work, notes the whole batch as a span.
+// The name is treated the same as for spans.
+void tr_batch(const char *name, uint64_t start, uint64_t end,
+        size_t per)
+{
+    if (!tr_enabled) return;
+
+    Ring *r = myRing();
+    if (r == NULL) return;
+
+    if (r->batchc == 0) {
+        r->batch = name;
+        r->batchStart = start;
+    }
+    r->batchEnd = end;
+
+    if (++r->batchc >= per) tr_endBatch();
+
+    return;
+}
+
+// Note the Calling Thread's Batch So Far
+
+// For when there's no more work to go in it.
+void tr_endBatch(void)
+{
+    if (!tr_enabled || ring == NULL || ring->batchc == 0) return;
+
+    ring->batchc = 0;
+    tr_span(ring->batch, ring->batchStart, ring->batchEnd);
+
+    return;
+}
+
+// Note a Set that Took a While
+
+// Only the slowest few sets noted on each thread are kept. The name is
+// treated the same as for spans.
+void tr_slow(const char *name, uint64_t start, uint64_t end,
+        const SetVal *set, size_t size)
+{
+    if (!tr_enabled) return;
+
+    Ring *r = myRing();
+    if (r == NULL) return;
+
+    // Take a free place, or the quickest one if it's quicker than this
+    Slow *s;
+    if (r->slowc < SLOWEST) s = r->slow + r->slowc++;
+    else {
+        s = r->slow;
+        for (size_t i = 1; i < SLOWEST; i++)
+            if (r->slow[i].end - r->slow[i].start < s->end - s->start)
+                s = r->slow + i;
+        if (end - start <= s->end - s->start) return;
+    }
+
+    s->name = name;
+    s->start = start;
+    s->end = end;
+    s->size = size < SET_MAX ? size : SET_MAX;
+    memcpy(s->set, set, s->size * sizeof(SetVal));
+
+    return;
+}
+
+// Current Time, in Nanoseconds
+uint64_t tr_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// ============ Helper Functions
+
+// Get the Calling Thread's Buffer
+// Returns NULL on error (read errno)
+
+// Made the first time a thread notes anything, and added to the list.
+Ring *myRing(void)
+{
+    if (ring != NULL) return ring;
+
+    Ring *r = malloc(sizeof(Ring));
+    if (r == NULL) return NULL;
+    r->count = 0;
+    r->slowc = 0;
+    r->batchc = 0;
+
+    pthread_mutex_lock(&ringLock);
+    r->tid = ringc++;
+    r->next = rings;
+    rings = r;
+    pthread_mutex_unlock(&ringLock);
+
+    snprintf(r->name, sizeof(r->name), "thread %zu", r->tid);
+    ring = r;
+
+    return r;
+}
+
+// Write the Start of a Complete Event
+
+// Times are written in microseconds from the start of tracing. The
+// event is left open for anything else to go in it.
+void writeSpan(FILE *f, const Ring *r, const char *name,
+        uint64_t start, uint64_t end, bool *first)
+{
+    fprintf(f, "%s{\"name\": \"%s\", \"ph\": \"X\", "
+            "\"ts\": %.3f, \"dur\": %.3f, \"pid\": %ld, \"tid\": %zu",
+            *first ? "" : ",\n", name,
+            (start - origin) / 1e3, (end - start) / 1e3,
+            (long) getpid(), r->tid);
+    *first = false;
+
+    return;
+}
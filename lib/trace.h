@@ -0,0 +1,42 @@
+// =============================== TRACE ===============================
+
+// See more info about this library in the source file `trace.c'.
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "setVal.h"
+
+// Whether Tracing is On
+extern bool tr_enabled;
+
+// Start Tracing
+int tr_start(const char *);
+
+// Finish Tracing and Write it Out
+int tr_finish(void);
+
+// Name the Calling Thread
+void tr_thread(const char *);
+
+// Note a Span on the Calling Thread
+void tr_span(const char *, uint64_t, uint64_t);
+
+// Note Work Towards a Batch
+void tr_batch(const char *, uint64_t, uint64_t, size_t);
+
+// Note the Calling Thread's Batch So Far
+void tr_endBatch(void);
+
+// Note a Set that Took a While
+void tr_slow(const char *, uint64_t, uint64_t,
+        const SetVal *, size_t);
+
+// Current Time, in Nanoseconds
+uint64_t tr_now(void);
+
+#endif
@@ -0,0 +1,110 @@
+// CHECK GENERATED TESTS AGAINST THE RECURSIVE TEST
+
+// Goes through every length-4 and length-5 set up to some M-value, and
+// makes sure the generated tests give the same result as the recursive
+// test, with no initial reduction range and with a few others, and
+// again through the incremental test with the cache of reachable values
+// set up, which is the only test that reads it. Length-6 and length-7
+// sets, which have no generated tests, are then checked through the
+// incremental test alone, up to a smaller M-value, so its higher levels
+// are built and values past its bitsets come up.
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../lib/nulTest.h"
+
+// Largest Set Size Checked
+#define CHECK_MAX 7
+
+int recursiveTest(const unsigned long *, size_t,
+        unsigned long, unsigned long);
+
+size_t check(size_t, unsigned long, NT_Inc *);
+
+int main(int argc, char **argv)
+{
+    unsigned long maxm = argc > 1 ? strtoul(argv[1], NULL, 10) : 24;
+    size_t wrong = 0;
+
+    for (int cached = 0; cached <= 1; cached++)
+    {
+        NT_Inc *inc = NULL;
+        if (cached) {
+            inc = nt_initInc(5, maxm * maxm);
+            if (inc == NULL || nt_initCache(maxm, 0x10000)) {
+                perror("Cache");
+                return 1;
+            }
+        }
+
+        for (size_t size = 4; size <= 5; size++)
+            wrong += check(size, maxm, inc);
+
+        if (inc) nt_releaseInc(inc);
+    }
+
+    // Larger sizes, incrementally
+    {
+        unsigned long wideM = maxm / 2;
+        NT_Inc *inc = nt_initInc(CHECK_MAX, wideM * wideM);
+        if (inc == NULL) {
+            perror("Incremental");
+            return 1;
+        }
+
+        for (size_t size = 6; size <= CHECK_MAX; size++)
+            wrong += check(size, wideM, inc);
+
+        nt_releaseInc(inc);
+    }
+
+    nt_releaseCache();
+    printf("%zu Mismatches\n", wrong);
+
+    return wrong != 0;
+}
+
+// Check Every Set of a Size
+// Returns the number of mismatches
+
+// Goes through the incremental test if given a context for it; ranged
+// tests still go the usual way there.
+size_t check(size_t size, unsigned long maxm, NT_Inc *inc)
+{
+    const unsigned long ranges[][2] = {
+        {0, 0}, {0, maxm / 2}, {maxm / 3, 0}, {maxm / 3, maxm / 2}
+    };
+
+    unsigned long set[CHECK_MAX];
+    SetVal narrow[CHECK_MAX];
+    for (size_t i = 0; i < size; i++) set[i] = i + 1;
+
+    size_t wrong = 0;
+    while (set[size - 1] <= maxm)
+    {
+        for (size_t r = 0; r < 4; r++)
+        {
+            unsigned long lo = ranges[r][0], hi = ranges[r][1];
+            for (size_t i = 0; i < size; i++) narrow[i] = set[i];
+            int want = recursiveTest(set, size, lo, hi);
+            int got = inc ? nulTestInc(inc, narrow, size, lo, hi)
+                    : nulTest(narrow, size, lo, hi);
+            if (want == got) continue;
+
+            if (wrong++ < 10) {
+                printf("Mismatch, M: %lu to %lu:", lo, hi);
+                for (size_t i = 0; i < size; i++) printf(" %lu", set[i]);
+                printf(" (%d, not %d)\n", got, want);
+            }
+        }
+
+        // Next set in order
+        size_t i = 0;
+        while (i < size - 1 && set[i] + 1 == set[i + 1]) i++;
+        set[i]++;
+        for (size_t j = 0; j < i; j++) set[j] = j + 1;
+    }
+
+    return wrong;
+}
@@ -0,0 +1,290 @@
+// ============================== APRIORI ==============================
+
+// Copyright (c) 2023, Jacob Bates
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This program finds the innullifiable sets one size up from a record,
+// without going through every set of that size. Any subset of an
+// innullifiable set is innullifiable too, as supersets of nullifiable
+// sets are nullifiable, so every innullifiable set of the next size is
+// made up of sets left unmarked in the record. Those are the only
+// candidates that need the exhaustive test, and there are usually very
+// few of them next to every set in the M-range.
+
+// Sorted the combinadic way, the unmarked sets that share all but their
+// lowest value sit next to each other, so each of those groups is
+// joined up a pair at a time: (a, T) and (b, T) make (a, b, T). Every
+// set of the next size comes from exactly one pair like that, the one
+// without its lowest value and the one without its second lowest. Any
+// candidate with another subset that's marked in the record is dropped,
+// and the rest are tested, each thread taking a group at a time.
+
+// The output record has the same M-range as the source, with every set
+// marked except the candidates that passed, which are marked as tested
+// with no initial reduction range, so it can be used like a record
+// that's been weeded. It's only missing innullifiable sets if the
+// source has innullifiable sets marked, which none of these programs
+// do; sets left unmarked in the source that are really nullifiable only
+// mean more candidates. Subsets with an M-value below the source's
+// range can't be looked up, so they don't drop any candidates.
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <errno.h>
+#include <pthread.h>
+#include <string.h>
+
+#include "../lib/iface.h"
+#include "../lib/setRec.h"
+#include "../lib/nulTest.h"
+#include "../lib/metrics.h"
+
+// Set Records
+SR_Base *src = NULL;
+SR_Base *dest = NULL;
+size_t srcSize;
+char *srcFname, *destFname;
+
+// Unmarked Source Sets, one after Another
+SetVal *survivors = NULL;
+size_t survivorc = 0;
+size_t survivorCap = 0;
+
+// Where each Group of Survivors Starts, and the Next Group to Take
+size_t *groups = NULL;
+size_t groupc = 0;
+atomic_size_t nextGroup = 0;
+
+// Number of Threads
+size_t threads = 1;
+
+// Metrics
+MT_Seg *metrics = NULL;
+char *metricsFname = NULL;
+_Thread_local MT_Counters *counters = NULL;
+
+// Options
+bool verbose;
+
+// Usage Format String
+const char *usage =
+        "Usage: %s [-v] srcSize src.dat dest.dat "
+                "[threads [metrics.out]]\n"
+        "   -v      Verbose: Display Progress Messages\n";
+
+int main(int argc, char **argv)
+{
+    // ============ Command-Line Arguments
+
+    // Parse arguments, show usage on invalid
+    {
+        const Param params[6] = {PARAM_SIZE, PARAM_FNAME, PARAM_FNAME,
+                PARAM_CT, PARAM_FNAME, PARAM_END};
+
+        CK_IFACE_FN(optHandle("v", true, usage, argc, argv, &verbose));
+
+        CK_IFACE_FN(argParse(params, 3, usage, argc, argv,
+                &srcSize, &srcFname, &destFname, &threads,
+                &metricsFname));
+    }
+
+    // Validate Thread Count
+    if (threads < 1) {
+        fprintf(stderr, "Error: Must use at least 1 thread\n");
+        return 1;
+    }
+
+    // ============ Import Source and Gather Survivors
+    src = sr_initialize(srcSize);
+    CK_PTR(src);
+
+    CK_IFACE_FN(openImport(src, srcFname));
+
+    // Joining goes by the lowest values, which fixed values never are
+    if (sr_getFixedSize(src)) {
+        fprintf(stderr, "Error: Source Can't have Fixed Values\n");
+        return 1;
+    }
+
+    {
+        void gather(const SetVal *, size_t, char);
+
+        ssize_t res = sr_query(src, NULLIF, 0, NULL, &gather);
+        CK_RES(res);
+    }
+
+    // Groups share every value but the lowest
+    groups = calloc(survivorc + 1, sizeof(size_t));
+    CK_PTR(groups);
+    for (size_t i = 0; i < survivorc; i++) {
+        const SetVal *set = survivors + i * srcSize;
+        if (i == 0 || memcmp(set + 1, set + 1 - srcSize,
+                (srcSize - 1) * sizeof(SetVal)) != 0)
+            groups[groupc++] = i;
+    }
+    groups[groupc] = survivorc;
+
+    // ============ Create Destination
+
+    // Every set is nullifiable until a candidate passes
+    dest = sr_initialize(srcSize + 1);
+    CK_PTR(dest);
+
+    int res = sr_alloc(dest, srcSize + 1, sr_getMinM(src),
+            sr_getMaxM(src), 0, NULL);
+    CK_RES(res);
+
+    sr_fill(dest, NULLIF);
+    sr_setTested(dest, 0, 0);
+
+    // ============ Join and Test Candidates in Threads
+
+    // Print Information about Execution
+    if (verbose) {
+        fprintf(stderr, "src  - Size: %2zu; M: %4lu to %4lu\n",
+                srcSize, sr_getMinM(src), sr_getMaxM(src));
+        fprintf(stderr, "%zu Unmarked Sets in %zu Groups\n",
+                survivorc, groupc);
+        fprintf(stderr, "Joining and Testing with %zu Threads\n",
+                threads);
+    }
+
+    // Counters for Each Thread
+    metrics = mt_create(metricsFname, "apriori", threads, groupc);
+    CK_PTR(metrics);
+
+    {
+        void *threadOp(void *);
+
+        // Array for Threads
+        pthread_t th[threads];
+
+        // Iteratively Create Threads
+        for (size_t i = 0; i < threads; i++) {
+            errno = pthread_create(th + i, NULL, &threadOp,
+                    (void *) mt_counters(metrics, i));
+            CK_NO(errno);
+        }
+
+        // Iteratively Join Threads
+        for (size_t i = 0; i < threads; i++) {
+            errno = pthread_join(th[i], NULL);
+            CK_NO(errno);
+        }
+    }
+
+    mt_finish(metrics);
+
+    // ============ Export and Cleanup
+    MT_Totals totals;
+    mt_read(metrics, &totals);
+    fprintf(stderr, "%zu Innullifiable Sets -- Size: %2zu; "
+            "M: %4lu to %4lu; %zu Candidates Tested\n",
+            sr_getTotal(dest) - sr_getMarked(dest, NULLIF),
+            srcSize + 1, sr_getMinM(dest), sr_getMaxM(dest),
+            totals.outputs);
+
+    if (verbose) fprintf(stderr, "Writing Output Record...");
+    CK_IFACE_FN(openExport(dest, destFname));
+    if (verbose) fprintf(stderr, "Done\n");
+
+    sr_release(src);
+    sr_release(dest);
+    free(survivors);
+    free(groups);
+    mt_close(metrics);
+
+    return 0;
+}
+
+// Thread Function for Joining Groups
+void *threadOp(void *arg)
+{
+    void joinGroup(size_t);
+
+    // Argument is this Thread's Counters
+    counters = (MT_Counters *) arg;
+
+    size_t g;
+    while ((g = atomic_fetch_add(&nextGroup, 1)) < groupc) {
+        joinGroup(g);
+        mt_add(&counters->scanned, 1);
+    }
+
+    return NULL;
+}
+
+// Gather an Unmarked Source Set
+void gather(const SetVal *set, size_t size, char bits)
+{
+    (void) bits;
+
+    // Double the space when it runs out
+    if (survivorc == survivorCap) {
+        survivorCap = survivorCap ? survivorCap * 2 : 0x1000;
+        survivors = realloc(survivors,
+                survivorCap * size * sizeof(SetVal));
+        CK_PTR(survivors);
+    }
+
+    memcpy(survivors + survivorc++ * size, set, size * sizeof(SetVal));
+
+    return;
+}
+
+// Join a Group of Survivors
+
+// Pairs in the group make candidates with the two lowest values from
+// the pair and the rest shared. The two subsets without either of those
+// are the pair itself, so only the others are looked up in the source.
+void joinGroup(size_t g)
+{
+    size_t size = srcSize + 1;
+    SetVal cand[size];
+    SetVal sub[srcSize];
+
+    for (size_t i = groups[g]; i < groups[g + 1]; i++)
+        for (size_t j = i + 1; j < groups[g + 1]; j++)
+    {
+        const SetVal *a = survivors + i * srcSize;
+        const SetVal *b = survivors + j * srcSize;
+
+        // Survivors are in order, so within a group, lowest values are
+        // ascending
+        cand[0] = a[0];
+        cand[1] = b[0];
+        memcpy(cand + 2, a + 1, (srcSize - 1) * sizeof(SetVal));
+
+        // Drop the candidate if any other subset is marked
+        bool dropped = false;
+        for (size_t out = 2; out < size && !dropped; out++) {
+            size_t k = 0;
+            for (size_t v = 0; v < size; v++)
+                if (v != out) sub[k++] = cand[v];
+
+            int bits = sr_getBits(src, sub, srcSize);
+            CK_RES(bits);
+            dropped = bits & NULLIF;
+        }
+        if (dropped) continue;
+
+        // Test what's left
+        int res = nulTest(cand, size, 0, 0);
+        CK_RES(res);
+        mt_add(&counters->outputs, 1);
+
+        // Take the mark off the ones that pass
+        if (res == 1) {
+            size_t index = sr_getIndex(dest, cand);
+            sr_clear_slice(dest, NULLIF, index, index + 1);
+            CK_RES(sr_mark(dest, cand, size, TESTED));
+            mt_add(&counters->passes, 1);
+        }
+    }
+
+    return;
+}
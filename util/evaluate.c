@@ -4,26 +4,53 @@
 // SPDX-License-Identifier: BSD-2-Clause
 
 // This program takes in a record and displays the value representations
-// of all the unmarked sets.
+// of all the unmarked sets. It can also be restricted to the unmarked
+// sets that have passed the exhaustive test in a previous weed.
+
+// The sets are written out by a few threads at once, each formatting
+// its share into a large buffer, so even a huge list comes out about as
+// fast as it can be written. They come out in the record's order unless
+// asked otherwise, and can be written as text in columns, split by
+// commas, or as binary: either the values, or each set's index in the
+// record. With CSV or binary, only the sets go to the standard output,
+// and everything else to the standard error.
 
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 
-
 #include "../lib/iface.h"
 #include "../lib/setRec.h"
+#include "../lib/stream.h"
 
 // Set Record
 SR_Base *rec;
 size_t size;
 char *fname;
+size_t threads = 1;
 
 // Whether to List Out Sets
 bool disp;
+bool countOnly;
+
+// Whether to Only Look at Tested Sets
+bool onlyTested;
+
+// Output Format and Order
+bool csv, values, ranks;
+bool unordered;
 
 // Usage Format String
-const char *usage = "Usage: %s [-s] recSize rec.dat\n";
+const char *usage =
+        "Usage: %s [-stcbru] recSize rec.dat [threads]\n"
+        "   -s      Only Display Number of Sets\n"
+        "   -t      Only Sets that Passed the Exhaustive Test\n"
+        "Output Formats:\n"
+        "   -c      Values Split by Commas\n"
+        "   -b      Binary Values, as Wide as Built (32-bit by "
+                "Default)\n"
+        "   -r      Binary Indexes in Record, 64-bit\n"
+        "   -u      Sets in Any Order\n";
 
 int main(int argc, char **argv)
 {
@@ -31,12 +58,32 @@ int main(int argc, char **argv)
 
     // Parse arguments, show usage on invalid
     {
-        const Param params[3] = {PARAM_SIZE, PARAM_FNAME, PARAM_END};
+        const Param params[4] = {PARAM_SIZE, PARAM_FNAME, PARAM_CT,
+                PARAM_END};
 
         CK_IFACE_FN(argParse(params, 2, usage, argc, argv,
-                    &size, &fname));
+                    &size, &fname, &threads));
 
-        CK_IFACE_FN(optHandle("s", false, usage, argc, argv, &disp));
+        CK_IFACE_FN(optHandle("stcbru", true, usage, argc, argv,
+                &countOnly, &onlyTested, &csv, &values, &ranks,
+                &unordered));
+        disp = !countOnly;
+    }
+
+    // Pick the Output Format
+    ST_Format format = ST_TEXT;
+    if (csv + values + ranks > 1) {
+        fprintf(stderr, "Error: Only One Output Format at a Time\n");
+        return 1;
+    }
+    if (csv) format = ST_CSV;
+    if (values) format = ST_VALUES;
+    if (ranks) format = ST_RANKS;
+
+    // Validate Thread Count
+    if (threads < 1) {
+        fprintf(stderr, "Error: Must use at least 1 thread\n");
+        return 1;
     }
 
     // ============ Import Record
@@ -49,31 +96,39 @@ int main(int argc, char **argv)
     fprintf(stderr, "rec  - Size: %2zu; M: %4lu to %4lu\n",
             size, sr_getMinM(rec), sr_getMaxM(rec));
 
+    unsigned long testMin, testMax;
+    if (sr_getTested(rec, &testMin, &testMax))
+        fprintf(stderr, "Tested for Reduction M: %4lu to %4lu\n",
+                testMin, testMax);
+
     // ============ Query Record to Print Sets
     {
-        void printSet(const unsigned long *, size_t, char);
-
-        if (disp) printf("\n");
-
-        ssize_t res = sr_query(rec, NULLIF, 0, NULL,
-                disp ? &printSet : NULL);
+        // Only text has anything but sets on the standard output
+        FILE *info = disp && format != ST_TEXT ? stderr : stdout;
+
+        if (disp && format == ST_TEXT) printf("\n");
+
+        // Either all unmarked sets, or those that are also tested
+        char mask = NULLIF;
+        char bits = 0;
+        if (onlyTested) mask |= TESTED, bits |= TESTED;
+
+        // The record already knows how many are unmarked
+        ssize_t res;
+        if (disp)
+            res = st_dump(rec, mask, bits, stdout, format, !unordered,
+                    threads);
+        else if (onlyTested)
+            res = sr_query(rec, mask, bits, NULL, NULL);
+        else res = sr_getTotal(rec) - sr_getMarked(rec, NULLIF);
         CK_RES(res);
 
-        if (disp) printf("\n");
-        printf("%ld Total Unmarked Sets\n", res);
+        if (disp && format == ST_TEXT) printf("\n");
+        fprintf(info, "%ld Total %s Sets\n", res,
+                onlyTested ? "Tested Innullifiable" : "Unmarked");
     }
 
     sr_release(rec);
 
     return 0;
 }
-
-// Print a Set to the Standard Output
-void printSet(const unsigned long *set, size_t size, char bits)
-{
-    for (size_t i = 0; i < size; i++)
-        printf("%4lu", set[i]);
-    printf("\n");
-
-    return;
-}
@@ -0,0 +1,94 @@
+// ============================== EXTEND ===============================
+
+// Copyright (c) 2023, Jacob Bates
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This program raises the maximum M-value of a record, keeping all the
+// marks it already has, so a search can be taken further without
+// starting over. Sorted the combinadic way, the sets with the new
+// M-values all come after the ones already there, so the file only
+// grows at the end, and only that stretch and the header are written.
+
+// The record notes the maximum M-value it had before, which is where
+// the delta modes of Generation and Weed start working from, so only
+// sets involving the new values are gone through. Extending again keeps
+// the first note, so nothing in between is missed, until it's cleared
+// once the delta runs are done.
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+
+#include "../lib/iface.h"
+#include "../lib/setRec.h"
+
+// Set Record
+SR_Base *rec;
+size_t size;
+char *fname;
+unsigned long maxm = 0;
+
+// Options
+bool clearNote;
+
+// Usage Format String
+const char *usage =
+        "Usage: %s [-c] recSize rec.dat [maxm]\n"
+        "   -c      Clear the Note of the M-value Extended from, "
+                "before Extending\n";
+
+int main(int argc, char **argv)
+{
+    // ============ Command-Line Arguments
+
+    // Parse arguments, show usage on invalid
+    {
+        const Param params[4] = {PARAM_SIZE, PARAM_FNAME, PARAM_VAL,
+                PARAM_END};
+
+        CK_IFACE_FN(optHandle("c", true, usage, argc, argv, &clearNote));
+
+        CK_IFACE_FN(argParse(params, 2, usage, argc, argv,
+                &size, &fname, &maxm));
+    }
+
+    // ============ Extend Record
+    rec = sr_initialize(size);
+    CK_PTR(rec);
+
+    CK_IFACE_FN(openImport(rec, fname));
+
+    if (clearNote) sr_clearExtended(rec);
+
+    if (maxm != 0) {
+        if (maxm < sr_getMaxM(rec)) {
+            fprintf(stderr, "Max M-value Cannot be Lowered\n");
+            return 1;
+        }
+
+        if (sr_extend(rec, maxm)) {
+            if (errno != EINVAL) FAULT();
+            fprintf(stderr, "Max M-value must be Below Fixed Values, "
+                    "and Every Value must Fit in a Set\n");
+            return 1;
+        }
+    }
+
+    unsigned long prevMax;
+    size_t start;
+    if (sr_getExtended(rec, &prevMax, &start))
+        fprintf(stderr, "Extended -- Size: %2zu; M: %4lu to %4lu; "
+                "%zu New Sets above M: %4lu\n", size,
+                sr_getMinM(rec), sr_getMaxM(rec),
+                sr_getTotal(rec) - start, prevMax);
+    else fprintf(stderr, "Not Extended -- Size: %2zu; M: %4lu to %4lu\n",
+            size, sr_getMinM(rec), sr_getMaxM(rec));
+
+    // ============ Write Back and Cleanup
+    CK_IFACE_FN(openUpdate(rec, fname));
+
+    sr_release(rec);
+
+    return 0;
+}
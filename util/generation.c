@@ -31,26 +31,72 @@
 
 // This and the Weed program are the two programs which do *proper
 // work,* and so they have the ability to have their progress tracked.
-// When sent SIGUSR1, these will produce a progress update, sending a
-// small amount of data to a file provided in the argument list, ideally
-// a named pipe. It provides 64-bit binary representations of the number
-// of sets currently elapsed in the scan, as well as the total number of
-// sets. For Generation, it'll optionally also provide the number of
-// sets remaining unmarked in the output, and for Weed, it'll provide
-// the number of sets having passed the test so far.
-
+// Each thread keeps counters in a metrics file given in the argument
+// list, which the Monitor program (or anything else) can read while it
+// runs: the number of sets elapsed in the scan, out of the total, as
+// well as the sets produced by expansion and how many of those were
+// newly marked, and for Weed, the number of sets having passed the test
+// so far. When sent SIGUSR1, these can export the output record, and
+// Generation can also count the sets remaining unmarked in the output
+// and note that in the metrics.
+
+// Both can also keep checkpoints of the output record every so often,
+// along with how far through the scan they are, so a long run that's
+// stopped partway can be resumed from about where it was. Here, that
+// needs the output to be in a different file from the source, as it
+// can't be read back in as the source otherwise.
+
+// A run can also be split between processes, each scanning only its
+// own shard of the source, a contiguous slice of it, and marking its own
+// copy of the output, and the copies merged afterwards.
+
+// After records have been extended to a higher M-value, a delta run
+// only does the work the extension added. Source sets from before only
+// get expanded into destination sets with the new M-values, and only
+// source sets that are new themselves get expanded all the way, so the
+// run costs about as much as the new sets, not the whole range.
+
+// Sets are noted as fresh when they're first marked, here or by Weed,
+// so when a destination is built up over several runs, a frontier run
+// only expands the source sets that are fresh, and takes the note off
+// them afterwards, writing the source back. Sets marked in earlier
+// passes aren't gone over again.
+
+// Rather than pushing marks out from the source, a pull run walks
+// through the destination, each thread taking a contiguous chunk at a
+// time, and looks each set's reductions up in the source, marking it if
+// one is nullifiable. Every thread only writes to its own chunk, so it
+// can put marks in without atomics, and reads from the source are only
+// lookups. It marks the same sets as pushing.
+
+// A two-step run goes two sizes up without a record in between. Each
+// thread keeps a source set's expansions in a buffer, and expands each
+// of them again into the destination, but only from the first source
+// set it could have come from, looked up in the source, which also
+// tells whether it would have been marked as only a superset.
+
+// Each thread's time can also be traced, as spans for importing and
+// exporting, each thread's whole scan, and batches of expansions, along
+// with the sets that took longest to expand on each thread, to be
+// looked at in a trace viewer afterwards.
+
+#include <stdatomic.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 
 #include <errno.h>
 #include <pthread.h>
 #include <signal.h>
+#include <string.h>
 #include <unistd.h>
 
 #include "../lib/iface.h"
 #include "../lib/setRec.h"
 #include "../lib/expand.h"
+#include "../lib/metrics.h"
+#include "../lib/trace.h"
 
 // Toggles for each Expansion Phase
 bool expandSupers;
@@ -65,12 +111,47 @@ bool progExport;
 bool progUnmarked;
 bool intProg;
 
+// Checkpoint Options
+bool checkpoints;
+bool resume;
+
+// Tracing Option, and Sets Expanded per Span
+bool tracing;
+#define TRACE_BATCH 0x100
+
+// Sharding Option
+bool sharded;
+
+// Delta Option, and the Max M-values from before Extending
+bool delta;
+unsigned long srcPrev, destPrev;
+
+// Pull Option, Sets per Chunk, the Next Chunk to Take, and Where each
+// Thread's Chunks are Done up to
+bool pull;
+#define CHUNK 0x1000
+atomic_size_t nextChunk = 0;
+atomic_size_t *chunkAt = NULL;
+
+// Frontier Option, and Bits a Source Set must Have
+bool frontier;
+char srcMask = NULLIF;
+
+// Two-Step Option, each Thread's Sets from the First Step, and the
+// Source Set they're from
+bool twoStep;
+_Thread_local SetVal *firsts = NULL;
+_Thread_local size_t firstc = 0;
+_Thread_local size_t firstCap = 0;
+_Thread_local const SetVal *firstFrom = NULL;
+_Thread_local bool fromHere;
+
 // Set Records
 SR_Base *src = NULL;
 SR_Base *dest = NULL;
 size_t srcSize;
 char *srcFname, *destFname;
-size_t srcTotal;
+size_t scanTotal;
 
 // M-range
 unsigned long minM;
@@ -79,25 +160,54 @@ unsigned long maxM;
 // Number of Threads
 size_t threads = 1;
 
-// Progress
-volatile size_t *progv = NULL;
-char *progFname = NULL;
+// Shard of the Source to Scan
+size_t shard = 0, shards = 1;
+size_t shardEnd;
+
+// Checkpoints
+size_t resumeFrom = 0;
+pthread_mutex_t ckptLock = PTHREAD_MUTEX_INITIALIZER;
+
+// Metrics
+MT_Seg *metrics = NULL;
+char *metricsFname = NULL;
+_Thread_local MT_Counters *counters = NULL;
 sigset_t progmask;
 
 // Usage Format String
 const char *usage =
-        "Usage: %s [-cvsmxui] srcSize src.dat dest.dat "
-                "[threads [prog.out]]\n"
+        "Usage: %s [-cvsmxuikrthdfp2] srcSize src.dat dest.dat "
+                "[threads [metrics.out]] [i/n]\n"
         "   -c      Create/Overwrite Destination (M-range and Fixed "
                 "Values taken from Source)\n"
         "   -v      Verbose: Display Progress Messages\n"
         "Expansion Phases (both enabled by default):\n"
         "   -s      Supersets\n"
         "   -m      Mutations\n"
-        "Progress Updates:\n"
+        "Updates on SIGUSR1:\n"
         "   -x      Export Current Output Record\n"
-        "   -u      Include Count of Remaining Unmarked Sets\n"
-        "   -i      Generate Progress Update on Interrupt\n";
+        "   -u      Count Remaining Unmarked Sets into Metrics\n"
+        "   -i      Handle Interrupt like SIGUSR1\n"
+        "Checkpoints (Destination not the Same File as Source):\n"
+        "   -k      Keep Checkpoints Periodically, and on SIGUSR1 "
+                "with -x\n"
+        "   -r      Resume from Last Checkpoint\n"
+        "Tracing:\n"
+        "   -t      Trace Threads into dest.dat.trace.json\n"
+        "Sharding (Merge the Destinations Afterwards):\n"
+        "   -h      Only Scan Shard i of n (from 0) of Source, "
+                "Given Last\n"
+        "Delta (after Extending the Records):\n"
+        "   -d      Only Expand into Sets New since Destination was "
+                "Extended\n"
+        "Frontier:\n"
+        "   -f      Only Expand Source Sets Marked since the Last "
+                "Frontier Run\n"
+        "Pull (Scanning and Sharding the Destination):\n"
+        "   -p      Mark Destination Sets by Looking up their "
+                "Reductions in Source\n"
+        "Two Steps (Destination Two Sizes Up):\n"
+        "   -2      Expand Twice, without a Record in Between\n";
 
 int main(int argc, char **argv)
 {
@@ -108,12 +218,59 @@ int main(int argc, char **argv)
         const Param params[6] = {PARAM_SIZE, PARAM_FNAME, PARAM_FNAME,
                 PARAM_CT, PARAM_FNAME, PARAM_END};
 
+        CK_IFACE_FN(optHandle("cvsmxuikrthdfp2", true, usage, argc,
+                argv, &omitImportDest, &verbose, &expandSupers,
+                &expandMutate, &progExport, &progUnmarked, &intProg,
+                &checkpoints, &resume, &tracing, &sharded, &delta,
+                &frontier, &pull, &twoStep));
+
+        if (sharded)
+            CK_IFACE_FN(shardParse(usage, &argc, argv, &shard, &shards));
+
         CK_IFACE_FN(argParse(params, 3, usage, argc, argv,
-                &srcSize, &srcFname, &destFname, &threads, &progFname));
+                &srcSize, &srcFname, &destFname, &threads,
+                &metricsFname));
+    }
 
-        CK_IFACE_FN(optHandle("cvsmxui", true, usage, argc, argv,
-                &omitImportDest, &verbose, &expandSupers, &expandMutate,
-                &progExport, &progUnmarked, &intProg));
+    // Start Tracing
+    if (tracing) {
+        char traceFname[strlen(destFname) + 12];
+        snprintf(traceFname, sizeof(traceFname), "%s.trace.json",
+                destFname);
+        CK_RES(tr_start(traceFname));
+        tr_thread("main");
+    }
+
+    // Checkpoints of the destination would overwrite the source
+    if ((checkpoints || resume) && strcmp(srcFname, destFname) == 0) {
+        fprintf(stderr, "Error: Checkpoints need Destination to be a "
+                "Different File\n");
+        return 1;
+    }
+
+    // The source is written back after a frontier run, and shards
+    // writing back the same source would clobber each other
+    if (frontier && (sharded || strcmp(srcFname, destFname) == 0)) {
+        fprintf(stderr, "Error: Frontier Runs need Destination to be a "
+                "Different File, and can't be Sharded\n");
+        return 1;
+    }
+    if (frontier) srcMask |= FRESH;
+
+    // Pulling goes over every destination set, so there's no telling it
+    // what's new in the source
+    if (pull && (delta || frontier)) {
+        fprintf(stderr, "Error: Pull Runs can't be Delta or Frontier "
+                "Runs\n");
+        return 1;
+    }
+
+    // Two steps go through sets in between that aren't in any record,
+    // so there's no pulling from them, and no telling which are new
+    if (twoStep && (pull || delta)) {
+        fprintf(stderr, "Error: Two-Step Runs can't be Pull or Delta "
+                "Runs\n");
+        return 1;
     }
 
     // Default to all expansion phases
@@ -128,12 +285,12 @@ int main(int argc, char **argv)
         return 1;
     }
 
-    // Block Progress Signal
+    // Block Update Signal
     sigemptyset(&progmask);
     sigaddset(&progmask, SIGUSR1);
     sigprocmask(SIG_BLOCK, &progmask, NULL);
 
-    // Set up Handler for Progress
+    // Set up Handler for Updates
     {
         void progHandler(int);
         struct sigaction act = {0};
@@ -155,16 +312,42 @@ int main(int argc, char **argv)
 
     // Initialize Records
     src = sr_initialize(srcSize);
-    dest = sr_initialize(srcSize + 1);
+    dest = sr_initialize(srcSize + 1 + twoStep);
     CK_PTR(src);
     CK_PTR(dest);
 
     // Import Source Record from File
+    uint64_t traced = tr_now();
     CK_IFACE_FN(openImport(src, srcFname));
-    srcTotal = sr_getTotal(src);
+    tr_span("import", traced, tr_now());
+
+    // Records from before sets were noted as fresh have none to expand
+    if (frontier && sr_getMarked(src, FRESH) == 0
+            && sr_getMarked(src, NULLIF) > 0)
+        fprintf(stderr, "Warning: No Fresh Sets in Source, though %zu "
+                "are Marked; Records Marked before Fresh Notes need a "
+                "Run without -f first\n", sr_getMarked(src, NULLIF));
+
+    // Make sure an old checkpoint isn't mistaken for ours
+    if (checkpoints && !resume) CK_IFACE_FN(clearCheckpoint(destFname));
+
+    // If there's a checkpoint to resume, the destination's in progress
+    if (resume && omitImportDest) {
+        char ckpt[strlen(destFname) + 10];
+        snprintf(ckpt, sizeof(ckpt), "%s.ckpt", destFname);
+        if (access(ckpt, F_OK) == 0) omitImportDest = false;
+    }
 
     // Import Destination Record from File
-    if (!omitImportDest) CK_IFACE_FN(openImport(dest, destFname));
+    if (!omitImportDest) {
+        traced = tr_now();
+        CK_IFACE_FN(openImport(dest, destFname));
+        tr_span("import", traced, tr_now());
+
+        // Pick up where the last checkpoint left off
+        if (resume)
+            CK_IFACE_FN(loadCheckpoint(dest, destFname, &resumeFrom));
+    }
 
     // Or Create it from Scratch
     else {
@@ -173,11 +356,19 @@ int main(int argc, char **argv)
         for (size_t i = 0; i < fixedSize; i++)
             fixed[i] = sr_getFixedValue(src, i);
 
-        int res = sr_alloc(dest, srcSize + 1 - fixedSize,
+        int res = sr_alloc(dest, srcSize + 1 + twoStep - fixedSize,
                 sr_getMinM(src), sr_getMaxM(src), fixedSize, fixed);
         CK_RES(res);
     }
 
+    // Only scan our shard, if the record we scan is split between
+    // processes: the source, or the destination when pulling
+    scanTotal = sr_getTotal(pull ? dest : src);
+    size_t shardStart = scanTotal * shard / shards;
+    shardEnd = scanTotal * (shard + 1) / shards;
+    if (resumeFrom < shardStart) resumeFrom = shardStart;
+    if (resumeFrom > shardEnd) resumeFrom = shardEnd;
+
     // If we have fixed values, the highest one is our M-range
     size_t fixedc = sr_getFixedSize(dest);
     if (fixedc) {
@@ -191,6 +382,18 @@ int main(int argc, char **argv)
         maxM = sr_getMaxM(dest);
     }
 
+    // A delta needs to know where the destination was extended from,
+    // and source sets are all from before unless it was extended too
+    if (delta) {
+        if (fixedc || !sr_getExtended(dest, &destPrev, NULL)) {
+            fprintf(stderr, "Error: Delta Needs the Destination "
+                    "Extended, without Fixed Values\n");
+            return 1;
+        }
+        if (!sr_getExtended(src, &srcPrev, NULL))
+            srcPrev = sr_getMaxM(src);
+    }
+
     // ============ Perform Expansions in Threads
 
     // Print Information about Execution
@@ -201,25 +404,54 @@ int main(int argc, char **argv)
                 sr_getSize(dest), minM, maxM);
         fprintf(stderr, "Performing Generation with %zu Threads\n",
                 threads);
-        fprintf(stderr, "Expanding by: %s%s\n",
+        fprintf(stderr, "%s by: %s%s\n",
+                pull ? "Pulling" : "Expanding",
                 expandSupers ? "Supersets " : "",
                 expandMutate ? "Mutations " : "");
+        if (sharded)
+            fprintf(stderr, "Scanning Shard %zu of %zu: "
+                    "Sets %zu to %zu\n", shard, shards,
+                    shardStart, shardEnd);
+        if (delta)
+            fprintf(stderr, "Delta: Only into M above %lu, "
+                    "Except from Sources with M above %lu\n",
+                    destPrev, srcPrev);
+        if (frontier)
+            fprintf(stderr, "Frontier: %zu Fresh Source Sets\n",
+                    sr_getMarked(src, FRESH));
+        if (twoStep)
+            fprintf(stderr, "Two Steps: through Size %zu, without a "
+                    "Record\n", srcSize + 1);
+        if (resumeFrom > shardStart)
+            fprintf(stderr, "Resuming from Set %zu of %zu\n",
+                    resumeFrom, scanTotal);
     }
 
+    // Counters for Each Thread
+    metrics = mt_create(metricsFname, "gen", threads,
+            shardEnd - resumeFrom);
+    CK_PTR(metrics);
+
+    // Chunks of the Destination, when Pulling
+    atomic_store(&nextChunk, resumeFrom);
+    chunkAt = calloc(threads, sizeof(atomic_size_t));
+    CK_PTR(chunkAt);
+    for (size_t i = 0; i < threads; i++)
+        atomic_store(chunkAt + i, resumeFrom);
+
     // Use threads to do all the computing
     {
         void *threadOp(void *);
         void *threadUnblocked(void *);
+        void *threadCheckpoint(void *);
 
-        // Arrays for Threads and Args
+        // Array for Threads
         pthread_t th[threads];
-        progv = calloc(threads, sizeof(size_t));
-        CK_PTR(progv);
 
         // Iteratively Create Threads
         for (size_t i = 0; i < threads; i++) {
             errno = pthread_create(th + i, NULL, &threadOp,
-                    (void *) (progv + i));
+                    (void *) mt_counters(metrics, i));
             CK_NO(errno);
         }
 
@@ -228,6 +460,14 @@ int main(int argc, char **argv)
         errno = pthread_create(&handler, NULL, &threadUnblocked, NULL);
         CK_NO(errno);
 
+        // Create Checkpoint Thread
+        pthread_t keeper;
+        if (checkpoints) {
+            errno = pthread_create(&keeper, NULL, &threadCheckpoint,
+                    NULL);
+            CK_NO(errno);
+        }
+
         // Iteratively Join Threads
         for (size_t i = 0; i < threads; i++) {
             errno = pthread_join(th[i], NULL);
@@ -238,20 +478,47 @@ int main(int argc, char **argv)
         errno = pthread_cancel(handler);
         CK_NO(errno);
 
-        free((void *) progv);
-        progv = NULL;
+        // Stop Checkpoint Thread, letting it finish a checkpoint first
+        if (checkpoints) {
+            errno = pthread_cancel(keeper);
+            CK_NO(errno);
+            errno = pthread_join(keeper, NULL);
+            CK_NO(errno);
+        }
     }
 
+    mt_finish(metrics);
+
     // ============ Export and Cleanup
 
     // Export Destination
     if (verbose) fprintf(stderr, "Writing Output Record...");
-    CK_IFACE_FN(openExport(dest, destFname));
+    traced = tr_now();
+    if (checkpoints)
+        CK_IFACE_FN(saveCheckpoint(dest, destFname, shardEnd));
+    else CK_IFACE_FN(openExport(dest, destFname));
+    if (checkpoints || resume) CK_IFACE_FN(clearCheckpoint(destFname));
+    tr_span("export", traced, tr_now());
     if (verbose) fprintf(stderr, "Done\n");
 
+    // Take the frontier off the source, once the destination has
+    // everything expanded from it
+    if (frontier) {
+        if (verbose) fprintf(stderr, "Clearing Source Frontier...");
+        traced = tr_now();
+        sr_clear_slice(src, FRESH, 0, sr_getTotal(src));
+        CK_IFACE_FN(openUpdate(src, srcFname));
+        tr_span("export", traced, tr_now());
+        if (verbose) fprintf(stderr, "Done\n");
+    }
+
+    CK_RES(tr_finish());
+
     // Unlink Records
     sr_release(src);
     sr_release(dest);
+    mt_close(metrics);
+    free(chunkAt);
 
     return 0;
 }
@@ -259,18 +526,56 @@ int main(int argc, char **argv)
 // Thread Function for Performing Expansion
 void *threadOp(void *arg)
 {
-    void handleExpand(const unsigned long *, size_t, char);
+    void handleExpand(const SetVal *, size_t, char);
+    void handlePull(const SetVal *, size_t, char);
 
-    // Argument is a Reference for Progress Output
-    size_t *prog = (size_t *) arg;
+    // Argument is this Thread's Counters
+    counters = (MT_Counters *) arg;
 
     // Get Thread Number
-    size_t mod = prog - progv;
+    size_t mod = counters - mt_counters(metrics, 0);
+
+    if (tr_enabled) {
+        char name[32];
+        snprintf(name, sizeof(name), "worker %zu", mod);
+        tr_thread(name);
+    }
 
     // Perform expansion phases on every nullifiable set
-    ssize_t res = sr_query_parallel(src, NULLIF, NULLIF,
-            threads, mod, prog, &handleExpand);
-    CK_RES(res);
+    if (!pull) {
+        uint64_t traced = tr_now();
+        ssize_t res = sr_query_slice(src, srcMask, srcMask, resumeFrom,
+                shardEnd, threads, mod, &counters->scanned,
+                &handleExpand);
+        CK_RES(res);
+        tr_endBatch();
+        tr_span("scan", traced, tr_now());
+        free(firsts);
+    }
+
+    // Or pull marks into the destination a chunk at a time, skipping
+    // sets there's nothing more to mark on
+    else {
+        char mask = expandSupers ? ONLY_SUP : NULLIF;
+
+        size_t start;
+        while ((start = atomic_fetch_add(&nextChunk, CHUNK)) < shardEnd)
+        {
+            size_t end = start + CHUNK < shardEnd ? start + CHUNK
+                    : shardEnd;
+
+            uint64_t traced = tr_now();
+            ssize_t res = sr_query_range(dest, mask, 0, start, end,
+                    NULL, &handlePull);
+            CK_RES(res);
+            tr_endBatch();
+            tr_span("chunk", traced, tr_now());
+
+            mt_add(&counters->scanned, end - start);
+            atomic_store(chunkAt + mod, end);
+        }
+        atomic_store(chunkAt + mod, shardEnd);
+    }
 
     return NULL;
 }
@@ -285,27 +590,85 @@ void *threadUnblocked(void *arg)
     return NULL;
 }
 
-// Progress Signal Handler
+// Thread Function for Checkpointing
+void *threadCheckpoint(void *arg)
+{
+    void checkpoint(void);
+
+    (void) arg;
+
+    tr_thread("checkpoint");
+
+    while (1)
+    {
+        sleep(CKPT_PERIOD);
+
+        // Don't get cancelled partway through
+        pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
+        checkpoint();
+        pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, NULL);
+    }
+
+    return NULL;
+}
+
+// Take a Checkpoint
+
+// Each thread goes through every Nth set of the source and counts how
+// many it's done, so the lowest of where their next sets are is where
+// to resume from. When pulling, it's the lowest of where each thread's
+// chunks are done up to, and the next chunk to be taken. If a
+// checkpoint's already being taken, this doesn't wait for it.
+void checkpoint(void)
+{
+    size_t next = shardEnd;
+
+    if (!pull) for (size_t i = 0; i < threads; i++) {
+        size_t done = atomic_load_explicit(
+                &mt_counters(metrics, i)->scanned, memory_order_acquire);
+        size_t at = resumeFrom + done * threads + i;
+        if (at < next) next = at;
+    }
+
+    else {
+        next = atomic_load(&nextChunk);
+        for (size_t i = 0; i < threads; i++) {
+            size_t at = atomic_load(chunkAt + i);
+            if (at < next) next = at;
+        }
+    }
+
+    if (next > shardEnd) next = shardEnd;
+
+    if (pthread_mutex_trylock(&ckptLock)) return;
+    uint64_t traced = tr_now();
+    CK_IFACE_FN(saveCheckpoint(dest, destFname, next));
+    tr_span("checkpoint", traced, tr_now());
+    pthread_mutex_unlock(&ckptLock);
+
+    return;
+}
+
+// Update Signal Handler
+
+// Progress is always there to read from the metrics, so this only has
+// to do the extra work it's asked to.
 void progHandler(int signo)
 {
-    if (signo != SIGUSR1) return;
+    void checkpoint(void);
 
-    // Sum of Progress
-    size_t prog = 0;
-    for (size_t i = 0; i < threads; i++) prog += progv[i];
+    if (signo != SIGUSR1) return;
 
-    // Count Unmarked Sets in Output if Specified
-    ssize_t remainingOutput = 0;
+    // Note Unmarked Sets in Output if Specified
     if (progUnmarked)
-        remainingOutput = sr_query(dest, NULLIF, 0, NULL, NULL);
-
-    // Push Progress Update
-    if (progFname != NULL)
-        if (pushProg(prog, srcTotal, remainingOutput, progFname))
-            FAULT();
+        mt_setUnmarked(metrics,
+                sr_getTotal(dest) - sr_getMarked(dest, NULLIF));
 
     // Export Destination if Specified
-    if (progExport) CK_IFACE_FN(openExport(dest, destFname));
+    if (progExport) {
+        if (checkpoints) checkpoint();
+        else CK_IFACE_FN(openUpdate(dest, destFname));
+    }
 
     return;
 }
@@ -315,7 +678,7 @@ void intHandler(int signo)
 {
     if (signo != SIGINT) return;
 
-    // Generate Progress Update if Specified
+    // Handle Like an Update if Specified
     if (intProg) progHandler(SIGUSR1);
 
     // Exit the program
@@ -326,41 +689,249 @@ void intHandler(int signo)
 
 // Set Expansion Function
 
-void handleExpand(const unsigned long *set, size_t size, char bits)
+void handleExpand(const SetVal *set, size_t size, char bits)
 {
-    void elim_onlySup(const unsigned long *, size_t);
-    void elim_nul(const unsigned long *, size_t);
+    void elim_onlySup(const SetVal *, size_t);
+    void elim_nul(const SetVal *, size_t);
+    void expandTwice(const SetVal *, size_t, char, unsigned long);
+
+    uint64_t traced = tr_enabled ? tr_now() : 0;
+
+    // For a delta, sets from before the extension were already
+    // expanded up to where the destination was
+    unsigned long lo = minM;
+    if (delta && set[size - 1] <= srcPrev && destPrev >= lo)
+        lo = destPrev + 1;
+
+    // Going two sizes up, the sets in between are expanded again
+    if (twoStep) expandTwice(set, size, bits, lo);
 
     // Either way, a nullifiable set's supersets should be marked;
     // further mutations are accounted for
-    if (expandSupers)
-        expand(set, size, minM, maxM, EXPAND_SUPERS, &elim_onlySup);
+    else if (expandSupers)
+        expand(set, size, lo, maxM, EXPAND_SUPERS, &elim_onlySup);
 
     // Introduce Mutations, but only if not touched by supersets; don't
     // rule out further mutations
-    if (expandMutate) if (!(bits & ONLY_SUP))
-        expand(set, size, minM, maxM, EXPAND_MUT_ADD | EXPAND_MUT_MUL,
+    if (!twoStep && expandMutate) if (!(bits & ONLY_SUP))
+        expand(set, size, lo, maxM, EXPAND_MUT_ADD | EXPAND_MUT_MUL,
                 &elim_nul);
 
+    if (tr_enabled) {
+        uint64_t end = tr_now();
+        tr_slow("expand", traced, end, set, size);
+        tr_batch("expansions", traced, end, TRACE_BATCH);
+    }
+
+    return;
+}
+
+// Two-Step Set Expansion
+
+// Expands a source set the same way as above, but keeps what it makes
+// in this thread's buffer rather than a record, and expands each of
+// those again into the destination, once each, however many times they
+// were made. A set in between would have been marked as only a
+// superset if any of its subsets is nullifiable in the source, not just
+// this one, and then only its supersets are marked. What it's expanded
+// into doesn't depend on which source set it came from, so it's only
+// expanded from the first one it could have come from, and passed over
+// from the rest: the first nullifiable subset, or the first reduction
+// that would have been mutated. Sets in between are kept whether or not
+// a record in between would have room for them, so with fixed values,
+// where only the highest fixed value bounds what expansion makes, a set
+// whose other values go past the M-range is still expanded again, and
+// can lead back into the destination's range.
+void expandTwice(const SetVal *set, size_t size, char bits,
+        unsigned long lo)
+{
+    void keepFirst(const SetVal *, size_t);
+    void elim_onlySup(const SetVal *, size_t);
+    void elim_nul(const SetVal *, size_t);
+    bool firstParent(const SetVal *, size_t);
+    int cmpFirst(const void *, const void *);
+
+    // First step, into the buffer
+    firstc = 0;
+    firstFrom = set;
+    if (expandSupers)
+        expand(set, size, lo, maxM, EXPAND_SUPERS, &keepFirst);
+    if (expandMutate) if (!(bits & ONLY_SUP))
+        expand(set, size, lo, maxM, EXPAND_MUT_ADD | EXPAND_MUT_MUL,
+                &keepFirst);
+
+    // Sets made more than once end up next to each other
+    size_t stride = size + 1;
+    qsort(firsts, firstc, stride * sizeof(SetVal), &cmpFirst);
+
+    // Second step, into the destination
+    SetVal sub[size];
+    for (size_t i = 0; i < firstc; i++)
+    {
+        const SetVal *mid = firsts + i * stride;
+        if (i > 0 && cmpFirst(mid, mid - stride) == 0) continue;
+
+        // Find the first subset that's nullifiable, if any
+        bool onlySup = false;
+        if (expandSupers) for (size_t out = 0; out <= size; out++) {
+            for (size_t v = 0, k = 0; v <= size; v++)
+                if (v != out) sub[k++] = mid[v];
+
+            int res = sr_getBits(src, sub, size);
+            CK_RES(res);
+            if (res & NULLIF) {
+                onlySup = true;
+                break;
+            }
+        }
+
+        // Or else the first reduction that would have been mutated
+        if (onlySup)
+            fromHere = memcmp(sub, set, size * sizeof(SetVal)) == 0;
+        else {
+            int res = reduce(mid, size + 1,
+                    EXPAND_MUT_ADD | EXPAND_MUT_MUL, &firstParent);
+            CK_RES(res);
+            if (res == 0) fromHere = true;
+        }
+        if (!fromHere) continue;
+
+        if (expandSupers)
+            expand(mid, size + 1, lo, maxM, EXPAND_SUPERS,
+                    &elim_onlySup);
+        if (expandMutate && !onlySup)
+            expand(mid, size + 1, lo, maxM,
+                    EXPAND_MUT_ADD | EXPAND_MUT_MUL, &elim_nul);
+    }
+
+    return;
+}
+
+// Compare Sets from the First Step
+
+// Only to bring equal ones together, so any consistent order will do.
+int cmpFirst(const void *a, const void *b)
+{
+    return memcmp(a, b, (srcSize + 1) * sizeof(SetVal));
+}
+
+// Set Pulling Function
+
+// Marks a destination set if any of its reductions is nullifiable in
+// the source, the same as it would be marked by expanding that set:
+// taking out a value gives the sets it's a superset of, and merging a
+// pair gives the sets it's a mutation of, which only count if they
+// weren't only supersets themselves.
+void handlePull(const SetVal *set, size_t size, char bits)
+{
+    bool pullNul(const SetVal *, size_t);
+    bool pullMut(const SetVal *, size_t);
+
+    uint64_t traced = tr_enabled ? tr_now() : 0;
+
+    char found = 0;
+    if (expandSupers) {
+        int res = reduce(set, size, EXPAND_SUPERS, &pullNul);
+        CK_RES(res);
+        if (res) found = NULLIF | ONLY_SUP;
+    }
+    if (!found && expandMutate && !(bits & NULLIF)) {
+        int res = reduce(set, size, EXPAND_MUT_ADD | EXPAND_MUT_MUL,
+                &pullMut);
+        CK_RES(res);
+        if (res) found = NULLIF;
+    }
+
+    // This thread is the only one on this chunk of the destination
+    if (found) {
+        int res = sr_markOwn(dest, set, size, found, FRESH);
+        CK_RES(res);
+        mt_add(&counters->marks, res);
+    }
+
+    if (tr_enabled) {
+        uint64_t end = tr_now();
+        tr_slow("reduce", traced, end, set, size);
+        tr_batch("reductions", traced, end, TRACE_BATCH);
+    }
+
+    return;
+}
+
+// Source Lookup Functions
+
+bool pullNul(const SetVal *set, size_t size)
+{
+    // Any nullifiable set has supersets
+    int res = sr_getBits(src, set, size);
+    CK_RES(res);
+    mt_add(&counters->outputs, 1);
+
+    return res & NULLIF;
+}
+
+bool pullMut(const SetVal *set, size_t size)
+{
+    // Only sets that aren't only supersets are mutated
+    int res = sr_getBits(src, set, size);
+    CK_RES(res);
+    mt_add(&counters->outputs, 1);
+
+    return (res & (NULLIF | ONLY_SUP)) == NULLIF;
+}
+
+// First Step Parent Lookup Function
+
+// Takes the first reduction that would have been mutated, noting if
+// it's the source set being expanded. Like the subset lookups, it isn't
+// counted as an output, since nothing is marked.
+bool firstParent(const SetVal *set, size_t size)
+{
+    int res = sr_getBits(src, set, size);
+    CK_RES(res);
+
+    if ((res & (NULLIF | ONLY_SUP)) != NULLIF) return false;
+    fromHere = memcmp(set, firstFrom, size * sizeof(SetVal)) == 0;
+
+    return true;
+}
+
+// First Step Keeping Function
+
+void keepFirst(const SetVal *set, size_t size)
+{
+    // Double the space when it runs out
+    if (firstc == firstCap) {
+        firstCap = firstCap ? firstCap * 2 : 0x100;
+        firsts = realloc(firsts, firstCap * size * sizeof(SetVal));
+        CK_PTR(firsts);
+    }
+
+    memcpy(firsts + firstc++ * size, set, size * sizeof(SetVal));
+
     return;
 }
 
 // Individual Set Elimination Functions
 
-void elim_onlySup(const unsigned long *set, size_t size)
+void elim_onlySup(const SetVal *set, size_t size)
 {
     // Mark this set as Nullifiable/Superset
-    int res = sr_mark(dest, set, size, NULLIF | ONLY_SUP);
+    int res = sr_markFresh(dest, set, size, NULLIF | ONLY_SUP, FRESH);
     CK_RES(res);
+    mt_add(&counters->outputs, 1);
+    mt_add(&counters->marks, res);
 
     return;
 }
 
-void elim_nul(const unsigned long *set, size_t size)
+void elim_nul(const SetVal *set, size_t size)
 {
     // Mark this set as Nullifiable only
-    int res = sr_mark(dest, set, size, NULLIF);
+    int res = sr_markFresh(dest, set, size, NULLIF, FRESH);
     CK_RES(res);
+    mt_add(&counters->outputs, 1);
+    mt_add(&counters->marks, res);
 
     return;
 }
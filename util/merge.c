@@ -0,0 +1,69 @@
+// ============================== MERGE ================================
+
+// Copyright (c) 2023, Jacob Bates
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This program combines records of the same shape into one, with every
+// set marked in it that's marked in any of them. It's for putting a run
+// back together after it's been split between processes, possibly on
+// different hosts, with each one scanning its own shard into its own
+// copy of the record. The first record is read in whole, and the rest
+// are ORed into it a stretch at a time, a vector at a time, so it takes
+// about as long as reading them. The records all need the same set
+// size, M-range, and fixed values, and where they were tested, the same
+// tested range.
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+
+#include "../lib/iface.h"
+#include "../lib/setRec.h"
+
+// Set Record
+SR_Base *rec;
+size_t size;
+char *outFname;
+char *inFname;
+
+// Usage Format String
+const char *usage =
+        "Usage: %s recSize out.dat in.dat [in.dat ...]\n";
+
+int main(int argc, char **argv)
+{
+    // ============ Command-Line Arguments
+
+    // Parse arguments, show usage on invalid; records past the first
+    // are taken as they are
+    {
+        const Param params[4] = {PARAM_SIZE, PARAM_FNAME, PARAM_FNAME,
+                PARAM_END};
+
+        CK_IFACE_FN(optHandle("", true, usage, argc, argv));
+
+        CK_IFACE_FN(argParse(params, 3, usage, argc < 4 ? argc : 4, argv,
+                &size, &outFname, &inFname));
+    }
+
+    // ============ Merge Records
+    rec = sr_initialize(size);
+    CK_PTR(rec);
+
+    CK_IFACE_FN(openImport(rec, inFname));
+    for (int i = 4; i < argc; i++)
+        CK_IFACE_FN(openMerge(rec, argv[i]));
+
+    fprintf(stderr, "Merged %d Records -- Size: %2zu; M: %4lu to %4lu; "
+            "%zu Unmarked Sets\n", argc - 3, size,
+            sr_getMinM(rec), sr_getMaxM(rec),
+            sr_getTotal(rec) - sr_getMarked(rec, NULLIF));
+
+    // ============ Export and Cleanup
+    CK_IFACE_FN(openExport(rec, outFname));
+
+    sr_release(rec);
+
+    return 0;
+}
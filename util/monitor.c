@@ -0,0 +1,139 @@
+// ============================== MONITOR ==============================
+
+// Copyright (c) 2023, Jacob Bates
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This program follows along with a Generation or Weed while it runs,
+// by reading the counters it keeps in its metrics file. Every so often,
+// it shows how many sets have been gone through out of the total, how
+// fast that's going, both lately and overall, and about how much longer
+// it'll take, along with how many sets were produced or tested, newly
+// marked, and passed the test. It only reads the file, so the program
+// being followed doesn't notice. If the file isn't there yet, it waits
+// for it, and it stops once the program has finished, or has exited
+// without finishing.
+
+#define _DEFAULT_SOURCE
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <errno.h>
+#include <signal.h>
+
+#include "../lib/iface.h"
+#include "../lib/metrics.h"
+
+// Metrics File
+char *fname;
+unsigned long interval = 500;
+
+// Options
+bool once;
+
+// Usage Format String
+const char *usage =
+        "Usage: %s [-o] metrics.out [interval]\n"
+        "   -o      Show Metrics Once and Exit\n"
+        "The interval is in milliseconds, 500 by default.\n";
+
+int main(int argc, char **argv)
+{
+    void waitFor(unsigned long);
+    void printTime(char *, size_t, double);
+
+    // ============ Command-Line Arguments
+
+    // Parse arguments, show usage on invalid
+    {
+        const Param params[3] = {PARAM_FNAME, PARAM_VAL, PARAM_END};
+
+        CK_IFACE_FN(argParse(params, 1, usage, argc, argv,
+                &fname, &interval));
+
+        CK_IFACE_FN(optHandle("o", true, usage, argc, argv, &once));
+    }
+
+    // ============ Open Metrics
+
+    // Wait until it's there and ready
+    MT_Seg *metrics;
+    while ((metrics = mt_open(fname)) == NULL)
+    {
+        if (errno != ENOENT && errno != EAGAIN) FAULT();
+        if (once) {
+            fprintf(stderr, "Error: '%s' isn't Ready\n", fname);
+            return 1;
+        }
+        waitFor(interval);
+    }
+
+    // ============ Show Metrics
+
+    MT_Totals cur, last = {0};
+    while (1)
+    {
+        mt_read(metrics, &cur);
+
+        // Rates since last time and overall, and time left
+        double recent = 0, overall = 0;
+        if (cur.elapsed > last.elapsed)
+            recent = (cur.scanned - last.scanned)
+                    / (cur.elapsed - last.elapsed);
+        if (cur.elapsed > 0) overall = cur.scanned / cur.elapsed;
+
+        char eta[16] = "--:--:--";
+        if (overall > 0 && cur.total >= cur.scanned)
+            printTime(eta, sizeof(eta),
+                    (cur.total - cur.scanned) / overall);
+
+        size_t percent = cur.total ? cur.scanned * 100 / cur.total : 100;
+
+        printf("\r%s: %zu / %zu (%zu%%), %.0f/s (%.0f/s overall), "
+                "ETA %s; out %zu, marked %zu, passed %zu",
+                cur.label, cur.scanned, cur.total, percent,
+                recent, overall, eta,
+                cur.outputs, cur.marks, cur.passes);
+        if (cur.unmarked) printf(", unmarked %zu", cur.unmarked);
+        printf("   ");
+        fflush(stdout);
+
+        // Stop once it's finished, or gone
+        if (cur.done || once) break;
+        if (kill(cur.pid, 0) && errno == ESRCH) {
+            printf("\n");
+            fprintf(stderr, "Error: Process %ld Exited Early\n",
+                    cur.pid);
+            mt_close(metrics);
+            return 1;
+        }
+
+        last = cur;
+        waitFor(interval);
+    }
+
+    printf("\n");
+    mt_close(metrics);
+
+    return 0;
+}
+
+// Wait for Some Milliseconds
+void waitFor(unsigned long ms)
+{
+    struct timespec ts = {ms / 1000, ms % 1000 * 1000000};
+    nanosleep(&ts, NULL);
+
+    return;
+}
+
+// Format a Number of Seconds as Hours, Minutes and Seconds
+void printTime(char *buf, size_t len, double secs)
+{
+    unsigned long s = secs;
+    snprintf(buf, len, "%lu:%02lu:%02lu", s / 3600, s / 60 % 60, s % 60);
+
+    return;
+}
@@ -0,0 +1,168 @@
+// ============================== RETILE ===============================
+
+// Copyright (c) 2023, Jacob Bates
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This program makes a record with a new range, the same way as Create,
+// and fills it in with the marks from existing records of the same set
+// size, so the way a search is split into records can be changed
+// without redoing any work. Sorted the combinadic way, any record is a
+// single stretch of all the sets of its size, whatever its M-range or
+// fixed values, so the sets a new record shares with an old one are a
+// single stretch of each, copied straight across. That covers splitting
+// a record into smaller M-ranges, joining neighbouring ones back up,
+// and turning fixed values into variable ones or back.
+
+// Sets in the new record that aren't in any of the old ones are left
+// unmarked, and the count of them is shown, so a gap doesn't go
+// unnoticed. Records that were tested have to agree on the range they
+// were tested under.
+
+#include <stdio.h>
+#include <stdlib.h>
+
+
+#include "../lib/iface.h"
+#include "../lib/setRec.h"
+
+// Set Record
+SR_Base *rec;
+size_t varSize;
+unsigned long minm, maxm;
+size_t fixedSize;
+char *fixedStr;
+unsigned long *fixed;
+char *fname;
+char *inFname;
+
+// Stretch of the New Record an Old One Covers
+typedef struct Stretch {
+    size_t start;
+    size_t end;
+} Stretch;
+
+// Usage Format String
+const char *usage =
+        "Usage: %s size minm maxm fixedSize \"fixedVals\" rec.dat "
+                "in.dat [in.dat ...]\n";
+
+int main(int argc, char **argv)
+{
+    // ============ Command-Line Arguments
+
+    // Parse arguments, show usage on invalid; records past the first
+    // are taken as they are
+    {
+        const Param params[8] = {PARAM_SIZE, PARAM_VAL, PARAM_VAL,
+                PARAM_SIZE, PARAM_STR, PARAM_FNAME, PARAM_FNAME,
+                PARAM_END};
+
+        CK_IFACE_FN(argParse(params, 7, usage, argc < 8 ? argc : 8, argv,
+                &varSize, &minm, &maxm, &fixedSize, &fixedStr, &fname,
+                &inFname));
+    }
+
+    // Validate Input
+    if (varSize < 1) {
+        fprintf(stderr, "Size Must be Positive\n");
+        return 1;
+    }
+
+    if (minm > maxm) {
+        fprintf(stderr, "Min M-value Cannot be Greater than Max\n");
+        return 1;
+    }
+
+    if (fixedSize > 4) {
+        fprintf(stderr, "No more than 4 Fixed Values\n");
+        return 1;
+    }
+
+    // Interpret Fixed Values
+    fixed = calloc(fixedSize, sizeof(unsigned long));
+    for (size_t i = 0; i < fixedSize; i++) {
+        char *next;
+        errno = 0;
+        fixed[i] = strtoul(fixedStr, &next, 0);
+        fixedStr = next;
+
+        if (errno) {
+            perror("Reading Fixed Values");
+            return 1;
+        }
+        if (*next != '\0' && *next != ' ') {
+            fprintf(stderr, "Could not Read Fixed Values\n");
+            return 1;
+        }
+    }
+
+    // ============ Create Record
+    fprintf(stderr, "Retiling... Size: %2zu; M: %4lu to %4lu\n",
+            varSize, minm, maxm);
+
+    rec = sr_initialize(varSize + fixedSize);
+    CK_PTR(rec);
+
+    if (sr_alloc(rec, varSize, minm, maxm, fixedSize, fixed)) {
+        if (errno != EINVAL) FAULT();
+        fprintf(stderr, "Fixed Values must be Ascending and Above Max "
+                "M-value, and Every Value must Fit in a Set\n");
+        return 1;
+    }
+
+    // ============ Copy Marks Across
+
+    // Each record covers one stretch of the new one
+    size_t total = sr_getTotal(rec);
+    size_t stretchc = argc - 7;
+    Stretch *stretches = calloc(stretchc, sizeof(Stretch));
+    CK_PTR(stretches);
+
+    for (size_t i = 0; i < stretchc; i++)
+    {
+        size_t start, sets = 0;
+        CK_IFACE_FN(openRetile(rec, argv[i + 7], &start, &sets));
+
+        fprintf(stderr, "'%s': %zu Sets\n", argv[i + 7], sets);
+        stretches[i].start = start;
+        stretches[i].end = start + sets;
+    }
+
+    // Count what the stretches cover together, overlaps only once
+    {
+        int cmpStretch(const void *, const void *);
+        qsort(stretches, stretchc, sizeof(Stretch), &cmpStretch);
+    }
+
+    size_t covered = 0, reached = 0;
+    for (size_t i = 0; i < stretchc; i++) {
+        size_t from = stretches[i].start > reached ? stretches[i].start
+                : reached;
+        if (stretches[i].end > from) {
+            covered += stretches[i].end - from;
+            reached = stretches[i].end;
+        }
+    }
+
+    if (covered < total)
+        fprintf(stderr, "Warning: %zu Sets not in Any Record, "
+                "Left Unmarked\n", total - covered);
+
+    // ============ Export and Cleanup
+    CK_IFACE_FN(openExport(rec, fname));
+
+    sr_release(rec);
+    free(fixed);
+    free(stretches);
+
+    return 0;
+}
+
+// Compare Stretches by where they Start
+int cmpStretch(const void *a, const void *b)
+{
+    size_t x = ((const Stretch *) a)->start;
+    size_t y = ((const Stretch *) b)->start;
+
+    return (x > y) - (x < y);
+}
@@ -0,0 +1,351 @@
+// ============================== SEARCH ===============================
+
+// Copyright (c) 2023, Jacob Bates
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This program finds the innullifiable sets of some size in an M-range
+// without a record at all, so it works for M-ranges far too large to
+// hold one. It builds sets up a value at a time, from the M-value down,
+// and tests each partial set as it goes; once one is nullifiable, every
+// set built on it is a superset of it, and nullifiable too, so none of
+// them are visited. The work goes with the number of partial sets that
+// survive rather than every set in the range.
+
+// Partial sets are tested incrementally: going down a level adds a new
+// lowest value under the same top values, and moving across changes
+// only the lowest one, which is exactly the case the incremental test
+// reuses its work for, so most tests are a single lookup.
+
+// The top two values of each set split the search up into subtrees,
+// which threads take one at a time, so large subtrees near the top of
+// the range don't hold up the rest. Going through each level's values
+// in ascending order gives sets in the same order as a record, and each
+// subtree's sets are written out as soon as the subtrees before it are
+// done, so the output is in the same order Evaluate gives. Subtrees are
+// only numbered, with their top values worked out from where each
+// M-value's start, and only the ones done ahead of those before them
+// are kept, so the memory goes with how far threads get ahead of each
+// other rather than the square of the M-range.
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <errno.h>
+#include <pthread.h>
+
+#include "../lib/iface.h"
+#include "../lib/nulTest.h"
+#include "../lib/stream.h"
+#include "../lib/metrics.h"
+
+// Set Size and M-range
+size_t size;
+unsigned long minm, maxm;
+
+// Number of Threads
+size_t threads = 1;
+
+// Subtrees by Number, where Each M-value's Start, and the Next to Take
+unsigned long lowest;
+size_t *firstOf = NULL;
+size_t subtreec = 0;
+atomic_size_t nextSubtree = 0;
+
+// Sets Found in a Subtree, Formatted
+typedef struct Output Output;
+struct Output {
+    size_t subtree;
+    char *buf;
+    size_t len;
+    size_t cap;
+};
+
+// Subtrees Written Out, those Done Ahead of Them, and a Lock on Writing
+size_t written = 0;
+Output *pending = NULL;
+size_t pendingc = 0;
+size_t pendingCap = 0;
+pthread_mutex_t writeLock = PTHREAD_MUTEX_INITIALIZER;
+
+// Metrics
+MT_Seg *metrics = NULL;
+char *metricsFname = NULL;
+_Thread_local MT_Counters *counters = NULL;
+
+// Each Thread's Incremental Testing Context, and Subtree Output
+_Thread_local NT_Inc *inc = NULL;
+_Thread_local Output out;
+
+// Options
+bool verbose;
+bool countOnly;
+bool csv;
+
+// Usage Format String
+const char *usage =
+        "Usage: %s [-vsc] size minm maxm [threads [metrics.out]]\n"
+        "   -v      Verbose: Display Progress Messages\n"
+        "   -s      Only Display Number of Sets\n"
+        "   -c      Values Split by Commas\n";
+
+int main(int argc, char **argv)
+{
+    // ============ Command-Line Arguments
+
+    // Parse arguments, show usage on invalid
+    {
+        const Param params[6] = {PARAM_SIZE, PARAM_VAL, PARAM_VAL,
+                PARAM_CT, PARAM_FNAME, PARAM_END};
+
+        CK_IFACE_FN(optHandle("vsc", true, usage, argc, argv,
+                &verbose, &countOnly, &csv));
+
+        CK_IFACE_FN(argParse(params, 3, usage, argc, argv,
+                &size, &minm, &maxm, &threads, &metricsFname));
+    }
+
+    // Validate Input
+    if (size < 3) {
+        fprintf(stderr, "Size Must be at Least 3\n");
+        return 1;
+    }
+
+    if (minm > maxm) {
+        fprintf(stderr, "Min M-value Cannot be Greater than Max\n");
+        return 1;
+    }
+
+    if (maxm > SET_VAL_MAX) {
+        fprintf(stderr, "Every Value must Fit in a Set\n");
+        return 1;
+    }
+
+    if (threads < 1) {
+        fprintf(stderr, "Error: Must use at least 1 thread\n");
+        return 1;
+    }
+
+    // ============ Split into Subtrees
+
+    // Every M-value with room for the rest of the set below it, and
+    // every value below that with room for the rest
+    lowest = minm > size ? minm : size;
+    firstOf = calloc(maxm >= lowest ? maxm - lowest + 1 : 1,
+            sizeof(size_t));
+    CK_PTR(firstOf);
+
+    for (unsigned long m = lowest; m <= maxm; m++) {
+        firstOf[m - lowest] = subtreec;
+        subtreec += m - (size - 1);
+    }
+
+    // ============ Search Subtrees in Threads
+
+    // Print Information about Execution
+    fprintf(stderr, "search - Size: %2zu; M: %4lu to %4lu\n",
+            size, lowest, maxm);
+    if (verbose)
+        fprintf(stderr, "Searching %zu Subtrees with %zu Threads\n",
+                subtreec, threads);
+
+    // Only text has anything but sets on the standard output
+    FILE *info = !countOnly && csv ? stderr : stdout;
+    if (!countOnly && !csv) printf("\n");
+
+    // Counters for Each Thread
+    metrics = mt_create(metricsFname, "search", threads, subtreec);
+    CK_PTR(metrics);
+
+    {
+        void *threadOp(void *);
+
+        // Array for Threads
+        pthread_t th[threads];
+
+        // Iteratively Create Threads
+        for (size_t i = 0; i < threads; i++) {
+            errno = pthread_create(th + i, NULL, &threadOp,
+                    (void *) mt_counters(metrics, i));
+            CK_NO(errno);
+        }
+
+        // Iteratively Join Threads
+        for (size_t i = 0; i < threads; i++) {
+            errno = pthread_join(th[i], NULL);
+            CK_NO(errno);
+        }
+    }
+
+    mt_finish(metrics);
+
+    // ============ Results and Cleanup
+    MT_Totals totals;
+    mt_read(metrics, &totals);
+
+    if (!countOnly && !csv) printf("\n");
+    fprintf(info, "%zu Total Innullifiable Sets\n", totals.passes);
+    if (fflush(stdout)) FAULT();
+
+    if (verbose)
+        fprintf(stderr, "%zu Partial Sets Tested\n", totals.outputs);
+
+    free(firstOf);
+    free(pending);
+    mt_close(metrics);
+
+    return 0;
+}
+
+// Thread Function for Searching Subtrees
+void *threadOp(void *arg)
+{
+    void descend(SetVal *, size_t);
+    void finish(size_t);
+
+    // Argument is this Thread's Counters
+    counters = (MT_Counters *) arg;
+
+    // Values as large as any set can be made into are kept as bitsets,
+    // as far as the testing context keeps any
+    inc = nt_initInc(size, maxm * maxm);
+    CK_PTR(inc);
+
+    SetVal set[size];
+
+    size_t s;
+    while ((s = atomic_fetch_add(&nextSubtree, 1)) < subtreec) {
+        // The M-value is the last one starting at or before it
+        unsigned long m = lowest;
+        for (size_t step = maxm - lowest + 1; step; step /= 2)
+            while (m + step <= maxm && firstOf[m + step - lowest] <= s)
+                m += step;
+
+        // Two distinct values are never nullifiable
+        set[size - 1] = m;
+        set[size - 2] = size - 1 + (s - firstOf[m - lowest]);
+        out.subtree = s;
+        descend(set, size - 2);
+
+        mt_add(&counters->scanned, 1);
+        finish(s);
+    }
+
+    nt_releaseInc(inc);
+    inc = NULL;
+    free(out.buf);
+
+    return NULL;
+}
+
+// Search Below a Partial Set
+
+// The set is filled in from the given index up, and that part is
+// innullifiable. Each value that could go just below it is tried in
+// ascending order, going further down on those that leave it
+// innullifiable, and noting the full sets.
+void descend(SetVal *set, size_t from)
+{
+    void note(const SetVal *);
+
+    size_t at = from - 1;
+    for (unsigned long v = at + 1; v < set[from]; v++)
+    {
+        set[at] = v;
+        int res = nulTestInc(inc, set + at, size - at, 0, 0);
+        CK_RES(res);
+        mt_add(&counters->outputs, 1);
+
+        // Nothing built on a nullifiable set can be innullifiable
+        if (res == 0) continue;
+
+        if (at == 0) note(set);
+        else descend(set, at);
+    }
+
+    return;
+}
+
+// Note an Innullifiable Set
+
+// Formats it into the thread's output for the subtree, unless only
+// counting.
+void note(const SetVal *set)
+{
+    mt_add(&counters->passes, 1);
+    if (countOnly) return;
+
+    // Make room for the largest this set could be
+    size_t need = out.len + size * ST_VAL_BYTES + 1;
+    if (need > out.cap) {
+        size_t cap = out.cap ? out.cap * 2 : 0x1000;
+        while (cap < need) cap *= 2;
+        out.buf = realloc(out.buf, cap);
+        CK_PTR(out.buf);
+        out.cap = cap;
+    }
+
+    char *p = st_putSet(out.buf + out.len, set, size,
+            csv ? ST_CSV : ST_TEXT);
+    out.len = p - out.buf;
+
+    return;
+}
+
+// Finish a Subtree
+
+// Writes its output if every subtree before it is written, along with
+// any done after it that were waiting on it; otherwise it's kept to
+// wait, so sets come out in order without any thread waiting on
+// another. There's nothing to order when only counting.
+void finish(size_t s)
+{
+    if (countOnly) return;
+
+    pthread_mutex_lock(&writeLock);
+
+    if (s != written) {
+        // Double the space when it runs out
+        if (pendingc == pendingCap) {
+            pendingCap = pendingCap ? pendingCap * 2 : 0x40;
+            pending = realloc(pending, pendingCap * sizeof(Output));
+            CK_PTR(pending);
+        }
+
+        // The waiting output takes the buffer with it
+        pending[pendingc++] = out;
+        out.buf = NULL;
+        out.cap = 0;
+    }
+    else {
+        if (out.len && fwrite(out.buf, 1, out.len, stdout) < out.len)
+            FAULT();
+        written++;
+
+        // Then any waiting on it, in turn
+        for (size_t i = 0; i < pendingc; ) {
+            Output *o = pending + i;
+            if (o->subtree != written) {
+                i++;
+                continue;
+            }
+
+            if (o->len && fwrite(o->buf, 1, o->len, stdout) < o->len)
+                FAULT();
+            free(o->buf);
+            written++;
+
+            *o = pending[--pendingc];
+            i = 0;
+        }
+    }
+
+    out.len = 0;
+
+    pthread_mutex_unlock(&writeLock);
+
+    return;
+}
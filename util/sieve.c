@@ -0,0 +1,227 @@
+// =============================== SIEVE ===============================
+
+// Copyright (c) 2023, Jacob Bates
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This program marks every superset of the nullifiable sets in a base
+// record on a record of any larger size, in a single pass, rather than
+// one size at a time through Generation. Usually the base is the weeded
+// size-3 record, the triples like a + b = c or a * b = c, and then none
+// of the records in between have to be made when only their supersets
+// are wanted on the target.
+
+// Each base set's supersets are marked straight through, in the order
+// they sit in the record, working out their indices as it goes rather
+// than from each set, so the cost is about one byte per set marked.
+// Threads take a base set at a time. The marks are the same as
+// Generation gives for supersets, only supersets with the fresh note.
+
+// Bases that come from mutations, sets of any size marked by Generation
+// or Weed, can be sieved in the same way, a record at a time, from the
+// same or other sizes; option `n` leaves out sets only marked as
+// supersets themselves, for when whatever they're supersets of is
+// sieved in as well.
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <errno.h>
+#include <pthread.h>
+#include <string.h>
+
+#include "../lib/iface.h"
+#include "../lib/setRec.h"
+#include "../lib/metrics.h"
+
+// Set Records
+SR_Base *base = NULL;
+SR_Base *dest = NULL;
+size_t baseSize, destSize;
+char *baseFname, *destFname;
+
+// Base Sets, one after Another, and the Next to Take
+SetVal *bases = NULL;
+size_t basec = 0;
+size_t baseCap = 0;
+atomic_size_t nextBase = 0;
+
+// Number of Threads
+size_t threads = 1;
+
+// Metrics
+MT_Seg *metrics = NULL;
+char *metricsFname = NULL;
+
+// Options
+bool createDest;
+bool verbose;
+bool notSupers;
+
+// Usage Format String
+const char *usage =
+        "Usage: %s [-cvn] baseSize base.dat destSize dest.dat "
+                "[threads [metrics.out]]\n"
+        "   -c      Create/Overwrite Destination (M-range and Fixed "
+                "Values taken from Base)\n"
+        "   -v      Verbose: Display Progress Messages\n"
+        "   -n      Leave out Base Sets Only Marked as Supersets\n";
+
+int main(int argc, char **argv)
+{
+    // ============ Command-Line Arguments
+
+    // Parse arguments, show usage on invalid
+    {
+        const Param params[7] = {PARAM_SIZE, PARAM_FNAME, PARAM_SIZE,
+                PARAM_FNAME, PARAM_CT, PARAM_FNAME, PARAM_END};
+
+        CK_IFACE_FN(optHandle("cvn", true, usage, argc, argv,
+                &createDest, &verbose, &notSupers));
+
+        CK_IFACE_FN(argParse(params, 4, usage, argc, argv,
+                &baseSize, &baseFname, &destSize, &destFname, &threads,
+                &metricsFname));
+    }
+
+    // Validate Input
+    if (baseSize < 1 || baseSize >= destSize) {
+        fprintf(stderr, "Base Size must be Positive, and Smaller "
+                "than Destination Size\n");
+        return 1;
+    }
+
+    if (threads < 1) {
+        fprintf(stderr, "Error: Must use at least 1 thread\n");
+        return 1;
+    }
+
+    // ============ Import Base and Gather Sets
+    base = sr_initialize(baseSize);
+    CK_PTR(base);
+
+    CK_IFACE_FN(openImport(base, baseFname));
+
+    {
+        void gather(const SetVal *, size_t, char);
+
+        char mask = notSupers ? NULLIF | ONLY_SUP : NULLIF;
+        ssize_t res = sr_query(base, mask, NULLIF, NULL, &gather);
+        CK_RES(res);
+    }
+
+    // ============ Import or Create Destination
+    dest = sr_initialize(destSize);
+    CK_PTR(dest);
+
+    if (createDest) {
+        // Same fixed values as the base
+        size_t fixedSize = sr_getFixedSize(base);
+        unsigned long *fixed = calloc(fixedSize, sizeof(unsigned long));
+        for (size_t i = 0; i < fixedSize; i++)
+            fixed[i] = sr_getFixedValue(base, i);
+
+        int res = sr_alloc(dest, destSize - fixedSize, sr_getMinM(base),
+                sr_getMaxM(base), fixedSize, fixed);
+        CK_RES(res);
+        free(fixed);
+    }
+    else CK_IFACE_FN(openImport(dest, destFname));
+
+    // ============ Sieve in Threads
+
+    // Print Information about Execution
+    if (verbose) {
+        fprintf(stderr, "base - Size: %2zu; M: %4lu to %4lu\n",
+                baseSize, sr_getMinM(base), sr_getMaxM(base));
+        fprintf(stderr, "dest - Size: %2zu; M: %4lu to %4lu\n",
+                destSize, sr_getMinM(dest), sr_getMaxM(dest));
+        fprintf(stderr, "Sieving %zu Base Sets with %zu Threads\n",
+                basec, threads);
+    }
+
+    // Counters for Each Thread
+    metrics = mt_create(metricsFname, "sieve", threads, basec);
+    CK_PTR(metrics);
+
+    {
+        void *threadOp(void *);
+
+        // Array for Threads
+        pthread_t th[threads];
+
+        // Iteratively Create Threads
+        for (size_t i = 0; i < threads; i++) {
+            errno = pthread_create(th + i, NULL, &threadOp,
+                    (void *) mt_counters(metrics, i));
+            CK_NO(errno);
+        }
+
+        // Iteratively Join Threads
+        for (size_t i = 0; i < threads; i++) {
+            errno = pthread_join(th[i], NULL);
+            CK_NO(errno);
+        }
+    }
+
+    mt_finish(metrics);
+
+    // ============ Export and Cleanup
+    MT_Totals totals;
+    mt_read(metrics, &totals);
+    fprintf(stderr, "%zu Sets Newly Marked from %zu Base Sets -- "
+            "Size: %2zu; M: %4lu to %4lu; %zu Unmarked\n",
+            totals.marks, basec, destSize, sr_getMinM(dest),
+            sr_getMaxM(dest),
+            sr_getTotal(dest) - sr_getMarked(dest, NULLIF));
+
+    if (verbose) fprintf(stderr, "Writing Output Record...");
+    if (createDest) CK_IFACE_FN(openExport(dest, destFname));
+    else CK_IFACE_FN(openUpdate(dest, destFname));
+    if (verbose) fprintf(stderr, "Done\n");
+
+    sr_release(base);
+    sr_release(dest);
+    free(bases);
+    mt_close(metrics);
+
+    return 0;
+}
+
+// Thread Function for Sieving Base Sets
+void *threadOp(void *arg)
+{
+    // Argument is this Thread's Counters
+    MT_Counters *counters = (MT_Counters *) arg;
+
+    size_t b;
+    while ((b = atomic_fetch_add(&nextBase, 1)) < basec) {
+        ssize_t res = sr_markSupersets(dest, bases + b * baseSize,
+                baseSize, NULLIF | ONLY_SUP, FRESH);
+        CK_RES(res);
+
+        mt_add(&counters->scanned, 1);
+        mt_add(&counters->marks, res);
+    }
+
+    return NULL;
+}
+
+// Gather a Base Set
+void gather(const SetVal *set, size_t size, char bits)
+{
+    (void) bits;
+
+    // Double the space when it runs out
+    if (basec == baseCap) {
+        baseCap = baseCap ? baseCap * 2 : 0x1000;
+        bases = realloc(bases, baseCap * size * sizeof(SetVal));
+        CK_PTR(bases);
+    }
+
+    memcpy(bases + basec++ * size, set, size * sizeof(SetVal));
+
+    return;
+}
@@ -12,18 +12,66 @@
 // specific M-range, and in fact it has the same effect: every set that
 // can be reduced to anything nullifiable in that range gets marked.
 
+// Sets that pass the test are marked as 'tested', and the record keeps
+// a note of the initial reduction range they were tested under. Passing
+// under some range means passing under any narrower range too, so later
+// weeds over the same range or a narrower one skip those sets, unless
+// forced to retest. Weeding over any other range clears the bits first.
+
+// There's also an incremental mode, where rather than each thread going
+// through every Nth set, threads take turns grabbing contiguous chunks
+// of the record, and test sets using the incremental variant of the
+// test, which reuses work between neighbouring sets. This pays off when
+// the sets left to test are dense in the record, but it only applies to
+// weeding with no initial reduction range.
+
+// The incremental test can also share a cache of what small sets of
+// values can be made into between threads. It's filled in up front for
+// sets of values up to the highest value in the record (or some
+// reasonable cap on that), and any others that come up are added as
+// they do.
+
+// Long weeds can keep checkpoints every so often, so if they're stopped
+// partway, they can be resumed from about where they were. With both,
+// exporting on SIGUSR1 takes a checkpoint too.
+
+// A run can also be split between processes, each scanning only its
+// own shard of the record, a contiguous slice of it, and marking its own
+// copy of the output, and the copies merged afterwards.
+
+// After a record has been extended to a higher M-value, a delta run
+// only scans the sets added by the extension, at the end of the record,
+// leaving the ones from before as they were.
+
+// Records of sets one smaller that have already been weeded can be
+// used as an oracle: when the test reduces a set a single step, and the
+// smaller set is in one of those records, it's looked up there rather
+// than tested any further. Sets marked there are nullifiable, and sets
+// that passed a weed with no initial reduction range are
+// innullifiable; anything else is tested as usual.
+
+// Each thread's time can also be traced, as spans for importing and
+// exporting, each chunk or each thread's whole scan, and batches of
+// tests, along with the slowest few tests on each thread, to be looked
+// at in a trace viewer afterwards.
+
+#include <stdatomic.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 
 #include <errno.h>
 #include <pthread.h>
 #include <signal.h>
+#include <string.h>
 #include <unistd.h>
 
 #include "../lib/iface.h"
 #include "../lib/setRec.h"
 #include "../lib/nulTest.h"
+#include "../lib/metrics.h"
+#include "../lib/trace.h"
 
 // Set Record
 SR_Base *rec = NULL;
@@ -37,27 +85,74 @@ unsigned long minm = 0, maxm = 0;
 // Number of Threads
 size_t threads = 1;
 
-// Progress
-volatile size_t *progv = NULL;
-char *progFname = NULL;
+// Chunks for Incremental Mode
+#define CHUNK 0x1000
+atomic_size_t nextChunk = 0;
+_Thread_local NT_Inc *inc = NULL;
+unsigned long valueLimit;
+atomic_size_t *chunkAt = NULL;
+
+// Tests per Span when Tracing
+#define TRACE_BATCH 0x400
+
+// Shard of the Record to Scan
+size_t shard = 0, shards = 1;
+size_t shardEnd;
+
+// Checkpoints
+size_t resumeFrom = 0;
+pthread_mutex_t ckptLock = PTHREAD_MUTEX_INITIALIZER;
+
+// Oracle Records, and whether their Passes can be Trusted
+SR_Base **oracles = NULL;
+bool *oracleTested = NULL;
+size_t oraclec = 0;
+
+// Cache of Reachable Values
+#define CACHE_PREMAX 40
+#define CACHE_ENTRIES 0x40000
+
+// Metrics
+MT_Seg *metrics = NULL;
+char *metricsFname = NULL;
+_Thread_local MT_Counters *counters = NULL;
 sigset_t progmask;
 
-// Counter of Sets that Passed
-pthread_mutex_t countLock = PTHREAD_MUTEX_INITIALIZER;
-size_t passedCount = 0;
+// Oracle Filenames, Split by Colons
+char *oracleFnames = NULL;
 
 // Options
 bool verbose;
 bool progExport;
 bool intProg;
+bool forceRetest;
+bool incremental;
+bool cacheValues;
+bool checkpoints;
+bool resume;
+bool tracing;
+bool sharded;
+bool delta;
+bool useOracles;
 
 // Usage Format String
 const char *usage =
-        "Usage: %s [-vxi] recSize rec.dat [minm maxm threads "
-                "[prog.out]]\n"
+        "Usage: %s [-vxifpckrthdo] recSize rec.dat [minm maxm threads "
+                "[metrics.out]] [o.dat[:o.dat...]] [i/n]\n"
         "   -v      Verbose: Display Progress Messages\n"
-        "   -x      Export Current Output Record on Progress Update\n"
-        "   -i      Generate Progress Update on Interrupt\n";
+        "   -x      Export Current Output Record on SIGUSR1\n"
+        "   -i      Handle Interrupt like SIGUSR1\n"
+        "   -f      Force Retesting of Sets Already Tested\n"
+        "   -p      Incremental Testing in Contiguous Chunks (Memory "
+                "per Thread Doubles with Size)\n"
+        "   -c      Cache Reachable Values of Small Sets, with -p\n"
+        "   -k      Keep Checkpoints Periodically\n"
+        "   -r      Resume from Last Checkpoint\n"
+        "   -t      Trace Threads into rec.dat.trace.json\n"
+        "   -h      Only Scan Shard i of n (from 0), Given Last\n"
+        "   -d      Only Scan Sets New since the Record was Extended\n"
+        "   -o      Look up Reduced Sets in Weeded Records One Smaller, "
+                "Given Before i/n\n";
 
 int main(int argc, char **argv)
 {
@@ -68,11 +163,33 @@ int main(int argc, char **argv)
         const Param params[7] = {PARAM_SIZE, PARAM_FNAME,
                 PARAM_VAL, PARAM_VAL, PARAM_CT, PARAM_FNAME, PARAM_END};
 
+        CK_IFACE_FN(optHandle("vxifpckrthdo", true, usage, argc, argv,
+                &verbose, &progExport, &intProg, &forceRetest,
+                &incremental, &cacheValues, &checkpoints, &resume,
+                &tracing, &sharded, &delta, &useOracles));
+
+        if (sharded)
+            CK_IFACE_FN(shardParse(usage, &argc, argv, &shard, &shards));
+
+        // Oracle records come just before the shard
+        if (useOracles) {
+            if (argc < 4) {
+                fprintf(stderr, usage, argv[0]);
+                return 1;
+            }
+            oracleFnames = argv[--argc];
+        }
+
         CK_IFACE_FN(argParse(params, 2, usage, argc, argv,
-                &size, &fname, &minm, &maxm, &threads, &progFname));
+                &size, &fname, &minm, &maxm, &threads, &metricsFname));
+    }
 
-        CK_IFACE_FN(optHandle("vxi", true, usage, argc, argv,
-                &verbose, &progExport, &intProg));
+    // Start Tracing
+    if (tracing) {
+        char traceFname[strlen(fname) + 12];
+        snprintf(traceFname, sizeof(traceFname), "%s.trace.json", fname);
+        CK_RES(tr_start(traceFname));
+        tr_thread("main");
     }
 
     // Validate Thread Count
@@ -81,12 +198,26 @@ int main(int argc, char **argv)
         return 1;
     }
 
-    // Block Progress Signal
+    // Only the incremental test reads the cache
+    if (cacheValues && !incremental) {
+        fprintf(stderr, "Error: Caching only Applies to Incremental "
+                "Testing\n");
+        return 1;
+    }
+
+    // The incremental test doesn't reduce sets one step at a time
+    if (useOracles && incremental) {
+        fprintf(stderr, "Error: Oracle Records Can't be Used with "
+                "Incremental Testing\n");
+        return 1;
+    }
+
+    // Block Update Signal
     sigemptyset(&progmask);
     sigaddset(&progmask, SIGUSR1);
     sigprocmask(SIG_BLOCK, &progmask, NULL);
 
-    // Set up Handler for Progress
+    // Set up Handler for Updates
     {
         void progHandler(int);
         struct sigaction act = {0};
@@ -108,8 +239,83 @@ int main(int argc, char **argv)
     rec = sr_initialize(size);
     CK_PTR(rec);
 
+    uint64_t traced = tr_now();
     CK_IFACE_FN(openImport(rec, fname));
     total = sr_getTotal(rec);
+    tr_span("import", traced, tr_now());
+
+    // Only scan the sets new since extending, for a delta
+    size_t deltaStart = 0;
+    if (delta && !sr_getExtended(rec, NULL, &deltaStart)) {
+        fprintf(stderr, "Error: Delta Needs the Record Extended\n");
+        return 1;
+    }
+
+    // Only scan our shard, if the record's split between processes
+    size_t shardStart = deltaStart
+            + (total - deltaStart) * shard / shards;
+    shardEnd = deltaStart
+            + (total - deltaStart) * (shard + 1) / shards;
+
+    // Pick up where the last checkpoint left off, or make sure an old
+    // one isn't mistaken for ours
+    if (resume) CK_IFACE_FN(loadCheckpoint(rec, fname, &resumeFrom));
+    else if (checkpoints) CK_IFACE_FN(clearCheckpoint(fname));
+    if (resumeFrom < shardStart) resumeFrom = shardStart;
+    if (resumeFrom > shardEnd) resumeFrom = shardEnd;
+    atomic_store(&nextChunk, resumeFrom);
+
+    // Import the oracle records, and only trust their passes if they
+    // were weeded with no initial reduction range; length-5 sets have a
+    // generated test that's quicker than looking them up
+    if (useOracles) {
+        int lookOracles(const unsigned long *, size_t);
+
+        if (size < 6) {
+            fprintf(stderr, "Error: Oracle Records Need Sets of Size 6 "
+                    "or More\n");
+            return 1;
+        }
+
+        for (char *c = oracleFnames; *c; c++) if (*c == ':') oraclec++;
+        oraclec++;
+        oracles = calloc(oraclec, sizeof(SR_Base *));
+        oracleTested = calloc(oraclec, sizeof(bool));
+        CK_PTR(oracles);
+        CK_PTR(oracleTested);
+
+        char *oname = oracleFnames;
+        for (size_t i = 0; i < oraclec; i++) {
+            char *colon = strchr(oname, ':');
+            if (colon != NULL) *colon = '\0';
+
+            oracles[i] = sr_initialize(size - 1);
+            CK_PTR(oracles[i]);
+            CK_IFACE_FN(openImport(oracles[i], oname));
+
+            unsigned long testMin, testMax;
+            oracleTested[i] = sr_getTested(oracles[i], &testMin, &testMax)
+                    && testMin == 0 && testMax == 0;
+
+            if (colon != NULL) oname = colon + 1;
+        }
+
+        nt_setOracle(size - 1, &lookOracles);
+    }
+
+    // Incremental testing keeps values up to the square of the highest
+    // value in any set as bitsets
+    {
+        size_t fixedc = sr_getFixedSize(rec);
+        unsigned long top = fixedc ? sr_getFixedValue(rec, fixedc - 1)
+                : sr_getMaxM(rec);
+        valueLimit = top * top;
+
+        // Fill in the cache before any threads start
+        if (cacheValues)
+            CK_RES(nt_initCache(top < CACHE_PREMAX ? top : CACHE_PREMAX,
+                    CACHE_ENTRIES));
+    }
 
     // ============ Iteratively Perform Test
 
@@ -120,22 +326,74 @@ int main(int argc, char **argv)
                 size, sr_getMinM(rec), sr_getMaxM(rec));
         fprintf(stderr, "Testing Unmarked Sets with %zu Threads\n",
                 threads);
+        if (incremental)
+            fprintf(stderr, "Testing Incrementally in Chunks\n");
+        if (cacheValues)
+            fprintf(stderr, "Caching Reachable Values of Small Sets\n");
+        if (sharded)
+            fprintf(stderr, "Scanning Shard %zu of %zu: "
+                    "Sets %zu to %zu\n", shard, shards,
+                    shardStart, shardEnd);
+        if (delta)
+            fprintf(stderr, "Delta: Only Sets %zu to %zu, "
+                    "New since Extending\n", deltaStart, total);
+        if (resumeFrom > shardStart)
+            fprintf(stderr, "Resuming from Set %zu of %zu\n",
+                    resumeFrom, total);
+        for (size_t i = 0; i < oraclec; i++)
+            fprintf(stderr, "Oracle - Size: %2zu; M: %4lu to %4lu; "
+                    "%s\n", size - 1, sr_getMinM(oracles[i]),
+                    sr_getMaxM(oracles[i]), oracleTested[i]
+                    ? "Marked and Passed" : "Marked Only");
+    }
+
+    // Previous passes still hold if we're testing under a range within
+    // the one they were tested under; otherwise, start over. Resuming
+    // always keeps the passes from before it stopped.
+    {
+        bool withinTested(unsigned long, unsigned long);
+
+        unsigned long testMin, testMax;
+        bool reuse = (resume || !forceRetest)
+                && sr_getTested(rec, &testMin, &testMax)
+                && withinTested(testMin, testMax);
+
+        if (!reuse) sr_clear(rec, TESTED);
+        sr_setTested(rec, minm, maxm);
+
+        if (verbose && reuse) {
+            ssize_t skipped = sr_query(rec, NULLIF | TESTED, TESTED,
+                    NULL, NULL);
+            CK_RES(skipped);
+            fprintf(stderr, "Skipping %zd Sets Previously Tested "
+                    "for M: %4lu to %4lu\n", skipped, testMin, testMax);
+        }
     }
 
+    // Counters for Each Thread
+    metrics = mt_create(metricsFname, "weed", threads,
+            shardEnd - resumeFrom);
+    CK_PTR(metrics);
+
+    // Where Each Thread is Up to, for Incremental Mode
+    chunkAt = calloc(threads, sizeof(atomic_size_t));
+    CK_PTR(chunkAt);
+    for (size_t i = 0; i < threads; i++)
+        atomic_store(chunkAt + i, resumeFrom);
+
     // Launch Threads to do the Computing
     {
         void *threadOp(void *);
         void *threadHandler(void *);
+        void *threadCheckpoint(void *);
 
-        // Arrays for Threads and Args
+        // Array for Threads
         pthread_t th[threads];
-        progv = calloc(threads, sizeof(size_t));
-        CK_PTR(progv);
 
         // Iteratively Create Threads
         for (size_t i = 0; i < threads; i++) {
             errno = pthread_create(th + i, NULL, &threadOp,
-                    (void *) (progv + i));
+                    (void *) mt_counters(metrics, i));
             CK_NO(errno);
         }
 
@@ -144,6 +402,14 @@ int main(int argc, char **argv)
         errno = pthread_create(&handler, NULL, &threadHandler, NULL);
         CK_NO(errno);
 
+        // Create Checkpoint Thread
+        pthread_t keeper;
+        if (checkpoints) {
+            errno = pthread_create(&keeper, NULL, &threadCheckpoint,
+                    NULL);
+            CK_NO(errno);
+        }
+
         // Iteratively Join Threads
         for (size_t i = 0; i < threads; i++) {
             errno = pthread_join(th[i], NULL);
@@ -154,15 +420,35 @@ int main(int argc, char **argv)
         errno = pthread_cancel(handler);
         CK_NO(errno);
 
-        free((void *) progv);
-        progv = NULL;
+        // Stop Checkpoint Thread, letting it finish a checkpoint first
+        if (checkpoints) {
+            errno = pthread_cancel(keeper);
+            CK_NO(errno);
+            errno = pthread_join(keeper, NULL);
+            CK_NO(errno);
+        }
     }
 
+    mt_finish(metrics);
+
     // ============ Export and Cleanup
     if (verbose) fprintf(stderr, "Writing Output Record...");
-    CK_IFACE_FN(openExport(rec, fname));
+    traced = tr_now();
+    if (checkpoints) CK_IFACE_FN(saveCheckpoint(rec, fname, shardEnd));
+    else CK_IFACE_FN(openExport(rec, fname));
+    if (checkpoints || resume) CK_IFACE_FN(clearCheckpoint(fname));
+    tr_span("export", traced, tr_now());
     if (verbose) fprintf(stderr, "Done\n");
 
+    CK_RES(tr_finish());
+
+    free(chunkAt);
+    nt_setOracle(0, NULL);
+    for (size_t i = 0; i < oraclec; i++) sr_release(oracles[i]);
+    free(oracles);
+    free(oracleTested);
+    nt_releaseCache();
+    mt_close(metrics);
     sr_release(rec);
 
     return 0;
@@ -171,47 +457,135 @@ int main(int argc, char **argv)
 // Thread Function for Testing Sets
 void *threadOp(void *arg)
 {
-    void testElim(const unsigned long *, size_t, char);
+    void testElim(const SetVal *, size_t, char);
 
-    // Argument is a Reference for Progress Output
-    size_t *prog = (size_t *) arg;
+    // Argument is this Thread's Counters
+    counters = (MT_Counters *) arg;
 
     // Get Thread Number
-    size_t mod = prog - progv;
+    size_t mod = counters - mt_counters(metrics, 0);
 
-    // For every unmarked set, run exhaustive test
-    ssize_t res = sr_query_parallel(rec, NULLIF, 0,
-            threads, mod, prog, &testElim);
-    CK_RES(res);
+    if (tr_enabled) {
+        char name[32];
+        snprintf(name, sizeof(name), "worker %zu", mod);
+        tr_thread(name);
+    }
+
+    // For every unmarked set not yet tested, run exhaustive test
+    if (!incremental) {
+        uint64_t traced = tr_now();
+        ssize_t res = sr_query_slice(rec, NULLIF | TESTED, 0,
+                resumeFrom, shardEnd, threads, mod, &counters->scanned,
+                &testElim);
+        CK_RES(res);
+        tr_endBatch();
+        tr_span("scan", traced, tr_now());
+    }
+
+    // Or do that incrementally, a chunk at a time
+    else {
+        inc = nt_initInc(size, valueLimit);
+        CK_PTR(inc);
+
+        size_t start;
+        while ((start = atomic_fetch_add(&nextChunk, CHUNK)) < shardEnd)
+        {
+            size_t end = start + CHUNK < shardEnd ? start + CHUNK
+                    : shardEnd;
+
+            uint64_t traced = tr_now();
+            ssize_t res = sr_query_range(rec, NULLIF | TESTED, 0,
+                    start, end, NULL, &testElim);
+            CK_RES(res);
+            tr_endBatch();
+            tr_span("chunk", traced, tr_now());
+
+            mt_add(&counters->scanned, end - start);
+            atomic_store(chunkAt + mod, end);
+        }
+        atomic_store(chunkAt + mod, shardEnd);
+
+        nt_releaseInc(inc);
+        inc = NULL;
+    }
 
     return NULL;
 }
 
 // Individual Set Testing/Elimination
-void testElim(const unsigned long *set, size_t size, char bits)
+void testElim(const SetVal *set, size_t size, char bits)
 {
     int res;
 
-    // Run the Test
-    res = nulTest(set, size, minm, maxm);
+    // Run the Test, timing it if tracing
+    uint64_t traced = tr_enabled ? tr_now() : 0;
+    if (inc != NULL) res = nulTestInc(inc, set, size, minm, maxm);
+    else res = nulTest(set, size, minm, maxm);
     CK_RES(res);
+    mt_add(&counters->outputs, 1);
+
+    if (tr_enabled) {
+        uint64_t end = tr_now();
+        tr_slow("nulTest", traced, end, set, size);
+        tr_batch("tests", traced, end, TRACE_BATCH);
+    }
 
     // Eliminate if Nullifiable
     if (res == 0) {
-        res = sr_mark(rec, set, size, NULLIF);
+        res = sr_markFresh(rec, set, size, NULLIF, FRESH);
         CK_RES(res);
+        mt_add(&counters->marks, res);
     }
 
-    // Otherwise, Increment Counter
+    // Otherwise, Note it Passed
     else {
-        pthread_mutex_lock(&countLock);
-        passedCount++;
-        pthread_mutex_unlock(&countLock);
+        res = sr_mark(rec, set, size, TESTED);
+        CK_RES(res);
+        mt_add(&counters->passes, 1);
     }
 
     return;
 }
 
+// Oracle Lookup
+
+// Reduced sets come in any order, so they're put in order first; a
+// doubled value is nullifiable straight away, and a value too large for
+// a set can't be in a record. Otherwise, the first record the set is
+// in that knows about it says.
+int lookOracles(const unsigned long *set, size_t size)
+{
+    SetVal sorted[size];
+    for (size_t i = 0; i < size; i++) {
+        if (set[i] > SET_VAL_MAX) return NT_UNKNOWN;
+
+        size_t j = i;
+        for (; j > 0 && sorted[j - 1] > set[i]; j--)
+            sorted[j] = sorted[j - 1];
+        if (j > 0 && sorted[j - 1] == set[i]) return 0;
+        sorted[j] = set[i];
+    }
+
+    for (size_t i = 0; i < oraclec; i++) {
+        int bits = sr_getBits(oracles[i], sorted, size);
+        CK_RES(bits);
+        if (bits & NULLIF) return 0;
+        if (bits & TESTED && oracleTested[i]) return 1;
+    }
+
+    return NT_UNKNOWN;
+}
+
+// Check if Current Range is Within a Tested Range
+
+// A maximum M-value of zero means there's no upper bound.
+bool withinTested(unsigned long testMin, unsigned long testMax)
+{
+    if (minm < testMin) return false;
+    if (testMax == 0) return true;
+    return maxm != 0 && maxm <= testMax;
+}
+
 // Thread Function for Intercepting Signals
 void *threadHandler(void *arg)
 {
@@ -222,22 +596,81 @@ void *threadHandler(void *arg)
     return NULL;
 }
 
-// Progress Signal Handler
-void progHandler(int signo)
+// Thread Function for Checkpointing
+void *threadCheckpoint(void *arg)
 {
-    if (signo != SIGUSR1) return;
+    void checkpoint(void);
 
-    // Sum of Progress
-    size_t prog = 0;
-    for (size_t i = 0; i < threads; i++) prog += progv[i];
+    (void) arg;
 
-    // Push Progress Update
-    if (progFname != NULL)
-        if (pushProg(prog, total, passedCount, progFname))
-            FAULT();
+    tr_thread("checkpoint");
+
+    while (1)
+    {
+        sleep(CKPT_PERIOD);
+
+        // Don't get cancelled partway through
+        pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
+        checkpoint();
+        pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, NULL);
+    }
+
+    return NULL;
+}
+
+// Take a Checkpoint
+
+// Notes the lowest set some thread might not be done with yet. Without
+// chunks, each thread goes through every Nth set and counts how many
+// it's done, so that's where its next set is. With chunks, each thread
+// notes the end of every chunk it finishes, and any chunk not handed
+// out yet starts past the next one. If a checkpoint's already being
+// taken, this doesn't wait for it.
+void checkpoint(void)
+{
+    size_t next = shardEnd;
+
+    if (!incremental) for (size_t i = 0; i < threads; i++) {
+        size_t done = atomic_load_explicit(
+                &mt_counters(metrics, i)->scanned, memory_order_acquire);
+        size_t at = resumeFrom + done * threads + i;
+        if (at < next) next = at;
+    }
+
+    else {
+        next = atomic_load(&nextChunk);
+        for (size_t i = 0; i < threads; i++) {
+            size_t at = atomic_load(chunkAt + i);
+            if (at < next) next = at;
+        }
+    }
+
+    if (next > shardEnd) next = shardEnd;
+
+    if (pthread_mutex_trylock(&ckptLock)) return;
+    uint64_t traced = tr_now();
+    CK_IFACE_FN(saveCheckpoint(rec, fname, next));
+    tr_span("checkpoint", traced, tr_now());
+    pthread_mutex_unlock(&ckptLock);
+
+    return;
+}
+
+// Update Signal Handler
+
+// Progress is always there to read from the metrics, so this only has
+// to export the record, when asked to.
+void progHandler(int signo)
+{
+    void checkpoint(void);
+
+    if (signo != SIGUSR1) return;
 
     // Export Record if Specified
-    if (progExport) CK_IFACE_FN(openExport(rec, fname));
+    if (progExport) {
+        if (checkpoints) checkpoint();
+        else CK_IFACE_FN(openUpdate(rec, fname));
+    }
 
     return;
 }
@@ -247,7 +680,7 @@ void intHandler(int signo)
 {
     if (signo != SIGINT) return;
 
-    // Generate Progress Update if Specified
+    // Handle Like an Update if Specified
     if (intProg) progHandler(SIGUSR1);
 
     // Exit the program